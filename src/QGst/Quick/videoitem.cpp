@@ -20,6 +20,7 @@
 #include "videosurface_p.h"
 #include <QtQuick/QSGNode>
 #include <QtQuick/QSGFlatColorMaterial>
+#include <QtQuick/QQuickWindow>
 
 namespace QGst {
 namespace Quick {
@@ -29,6 +30,7 @@ struct VideoItem::Private
     QPointer<VideoSurface> surface;
     bool surfaceDirty;
     QRectF targetArea;
+    QList<QMetaObject::Connection> windowConnections;
 };
 
 VideoItem::VideoItem(QQuickItem *parent)
@@ -41,6 +43,8 @@ VideoItem::VideoItem(QQuickItem *parent)
 VideoItem::~VideoItem()
 {
     setSurface(0);
+    for (const auto &connection : d->windowConnections)
+        disconnect(connection);
     delete d;
 }
 
@@ -53,6 +57,7 @@ void VideoItem::setSurface(VideoSurface *surface)
 {
     if (d->surface) {
         d->surface.data()->d->items.remove(this);
+        d->surface.data()->setItemVisibleArea(this, 0);
     }
 
     d->surface = surface;
@@ -60,9 +65,73 @@ void VideoItem::setSurface(VideoSurface *surface)
 
     if (d->surface) {
         d->surface.data()->d->items.insert(this);
+        updateVisibleArea();
     }
 }
 
+void VideoItem::itemChange(ItemChange change, const ItemChangeData &value)
+{
+    QQuickItem::itemChange(change, value);
+
+    switch (change) {
+    case ItemSceneChange:
+        for (const auto &connection : d->windowConnections)
+            disconnect(connection);
+        d->windowConnections.clear();
+
+        // minimizing or resizing the window does not reach the items
+        if (value.window) {
+            auto update = [this]() { updateVisibleArea(); };
+            d->windowConnections << connect(value.window, &QWindow::visibilityChanged, this, update)
+                                 << connect(value.window, &QWindow::widthChanged, this, update)
+                                 << connect(value.window, &QWindow::heightChanged, this, update);
+        }
+        updateVisibleArea();
+        break;
+    case ItemVisibleHasChanged:
+    case ItemOpacityHasChanged:
+    case ItemParentHasChanged:
+        updateVisibleArea();
+        break;
+    default:
+        break;
+    }
+}
+
+void VideoItem::geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry)
+{
+    QQuickItem::geometryChanged(newGeometry, oldGeometry);
+    updateVisibleArea();
+}
+
+/* The part of the item inside the window and inside the items clipping
+ * it, in device pixels. Items covering it are not taken into account,
+ * nor are the ancestors moving it around without resizing it. */
+void VideoItem::updateVisibleArea()
+{
+    if (!d->surface)
+        return;
+
+    qreal area = 0;
+    QQuickWindow *w = window();
+    if (w && isVisible() && w->visibility() != QWindow::Hidden
+          && w->visibility() != QWindow::Minimized) {
+        QRectF onScreen = mapRectToScene(boundingRect()) & QRectF(QPointF(), w->size());
+
+        for (QQuickItem *item = this; item && !onScreen.isEmpty(); item = item->parentItem()) {
+            if (item->opacity() <= 0)
+                onScreen = QRectF();
+            else if (item != this && item->clip())
+                onScreen &= item->mapRectToScene(item->boundingRect());
+        }
+
+        const qreal ratio = w->effectiveDevicePixelRatio();
+        area = onScreen.width() * onScreen.height() * ratio * ratio;
+    }
+
+    d->surface.data()->setItemVisibleArea(this, area);
+}
+
 #define G_TYPE_QREAL        ((sizeof(qreal) == sizeof(double)) ? G_TYPE_DOUBLE : G_TYPE_FLOAT)
 
 #if defined(QT_COORD_TYPE)
@@ -113,7 +182,17 @@ QSGNode* VideoItem::updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *data)
 
             d->targetArea = r;
         }
+    } else if (const GstQtQuick2VideoSinkInterface *iface = d->surface.data()->d->updateNodeInterface) {
+        GstElement *sink = d->surface.data()->d->videoSink;
+        if (iface->version >= 2) {
+            newNode = static_cast<QSGNode*>(iface->update_node_in_window(sink, oldNode, window(),
+                                                                         r.x(), r.y(), r.width(), r.height()));
+        } else {
+            newNode = static_cast<QSGNode*>(iface->update_node(sink, oldNode,
+                                                               r.x(), r.y(), r.width(), r.height()));
+        }
     } else {
+        //older sinks only have the signal
         const int count = 6; //this + oldNode + rect
         GValue *values = new GValue[count + 1];
         memset(values, 0, sizeof(GValue) * (count + 1));
@@ -54,7 +54,15 @@ protected:
     virtual QSGNode* updatePaintNode(QSGNode *oldNode,
                                      UpdatePaintNodeData *updatePaintNodeData);
 
+    /*! Reimplemented from QQuickItem, to tell the surface how much of
+     * this item is on screen. */
+    virtual void itemChange(ItemChange change, const ItemChangeData &value);
+    /*! Reimplemented from QQuickItem. */
+    virtual void geometryChanged(const QRectF &newGeometry, const QRectF &oldGeometry);
+
 private:
+    void updateVisibleArea();
+
     struct Private;
     Private *const d;
 };
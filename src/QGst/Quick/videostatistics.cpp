@@ -0,0 +1,92 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "videostatistics.h"
+
+namespace QGst {
+namespace Quick {
+
+VideoStatistics::VideoStatistics(GstElement *sink, QObject *parent)
+    : QObject(parent)
+    , m_sink(sink ? GST_ELEMENT(gst_object_ref(sink)) : nullptr)
+{
+    connect(&m_timer, &QTimer::timeout, this, &VideoStatistics::refresh);
+    if (m_sink)
+        m_timer.start(1000);
+}
+
+VideoStatistics::~VideoStatistics()
+{
+    if (m_sink)
+        gst_object_unref(m_sink);
+}
+
+int VideoStatistics::interval() const
+{
+    return m_timer.isActive() ? m_timer.interval() : 0;
+}
+
+void VideoStatistics::setInterval(int interval)
+{
+    if (interval == this->interval())
+        return;
+
+    if (interval > 0 && m_sink)
+        m_timer.start(interval);
+    else
+        m_timer.stop();
+    Q_EMIT intervalChanged();
+}
+
+void VideoStatistics::refresh()
+{
+    if (!m_sink)
+        return;
+
+    guint64 received = 0, rendered = 0;
+    guint replaced = 0;
+    gdouble uploadAverage = 0, uploadP99 = 0, latencyAverage = 0, latencyP99 = 0;
+    gdouble decodeAverage = 0, decodeP99 = 0;
+    g_object_get(m_sink,
+                 "frames-received", &received,
+                 "frames-rendered", &rendered,
+                 "replaced-frames", &replaced,
+                 "upload-time-average", &uploadAverage,
+                 "upload-time-p99", &uploadP99,
+                 "latency-average", &latencyAverage,
+                 "latency-p99", &latencyP99,
+                 "decode-time-average", &decodeAverage,
+                 "decode-time-p99", &decodeP99,
+                 nullptr);
+
+    // an idle pipeline does not wake up the bindings
+    if (received == m_framesReceived && rendered == m_framesRendered)
+        return;
+
+    m_framesReceived = received;
+    m_framesRendered = rendered;
+    m_framesReplaced = replaced;
+    m_uploadTimeAverage = uploadAverage;
+    m_uploadTimeP99 = uploadP99;
+    m_latencyAverage = latencyAverage;
+    m_latencyP99 = latencyP99;
+    m_decodeTimeAverage = decodeAverage;
+    m_decodeTimeP99 = decodeP99;
+    Q_EMIT changed();
+}
+
+} // namespace Quick
+} // namespace QGst
@@ -0,0 +1,104 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License as published
+    by the Free Software Foundation; either version 2.1 of the License, or
+    (at your option) any later version.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef QGST_QUICK_VIDEOSTATISTICS_H
+#define QGST_QUICK_VIDEOSTATISTICS_H
+
+#include <gst/gstelement.h>
+#include <QObject>
+#include <QTimer>
+
+namespace QGst {
+namespace Quick {
+
+/*!
+ * \brief The rendering statistics of a VideoSurface
+ *
+ * Mirrors the read-only statistics properties of the surface's
+ * qtquick2videosink, refreshing them periodically so that QML can bind
+ * to them, e.g. for an on-screen debugging overlay:
+ * \code
+ * Text {
+ *     text: "%1 frames, %2 us late".arg(videoSurface.statistics.framesRendered)
+ *                                   .arg(videoSurface.statistics.latencyAverage)
+ * }
+ * \endcode
+ *
+ * Times are in microseconds.
+ *
+ * \sa VideoSurface::statistics()
+ */
+class VideoStatistics : public QObject
+{
+    Q_OBJECT
+    Q_DISABLE_COPY(VideoStatistics)
+    Q_PROPERTY(quint64 framesReceived READ framesReceived NOTIFY changed)
+    Q_PROPERTY(quint64 framesRendered READ framesRendered NOTIFY changed)
+    Q_PROPERTY(quint64 framesReplaced READ framesReplaced NOTIFY changed)
+    Q_PROPERTY(double uploadTimeAverage READ uploadTimeAverage NOTIFY changed)
+    Q_PROPERTY(double uploadTimeP99 READ uploadTimeP99 NOTIFY changed)
+    Q_PROPERTY(double latencyAverage READ latencyAverage NOTIFY changed)
+    Q_PROPERTY(double latencyP99 READ latencyP99 NOTIFY changed)
+    Q_PROPERTY(double decodeTimeAverage READ decodeTimeAverage NOTIFY changed)
+    Q_PROPERTY(double decodeTimeP99 READ decodeTimeP99 NOTIFY changed)
+    Q_PROPERTY(int interval READ interval WRITE setInterval NOTIFY intervalChanged)
+public:
+    /*! Creates statistics for \a sink, which may be null */
+    explicit VideoStatistics(GstElement *sink, QObject *parent = nullptr);
+    ~VideoStatistics() override;
+
+    quint64 framesReceived() const { return m_framesReceived; }
+    quint64 framesRendered() const { return m_framesRendered; }
+    quint64 framesReplaced() const { return m_framesReplaced; }
+    double uploadTimeAverage() const { return m_uploadTimeAverage; }
+    double uploadTimeP99() const { return m_uploadTimeP99; }
+    double latencyAverage() const { return m_latencyAverage; }
+    double latencyP99() const { return m_latencyP99; }
+    /*! 0 unless the frames come from qtjpegdec */
+    double decodeTimeAverage() const { return m_decodeTimeAverage; }
+    double decodeTimeP99() const { return m_decodeTimeP99; }
+
+    /*! How often the values are refreshed, in milliseconds; 0 stops refreshing */
+    int interval() const;
+    void setInterval(int interval);
+
+public Q_SLOTS:
+    /*! Reads the current values from the sink */
+    void refresh();
+
+Q_SIGNALS:
+    void changed();
+    void intervalChanged();
+
+private:
+    GstElement * const m_sink;
+    QTimer m_timer;
+
+    quint64 m_framesReceived = 0;
+    quint64 m_framesRendered = 0;
+    quint64 m_framesReplaced = 0;
+    double m_uploadTimeAverage = 0;
+    double m_uploadTimeP99 = 0;
+    double m_latencyAverage = 0;
+    double m_latencyP99 = 0;
+    double m_decodeTimeAverage = 0;
+    double m_decodeTimeP99 = 0;
+};
+
+} // namespace Quick
+} // namespace QGst
+
+#endif // QGST_QUICK_VIDEOSTATISTICS_H
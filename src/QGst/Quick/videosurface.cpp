@@ -32,6 +32,8 @@ VideoSurface::VideoSurface(QObject *parent)
 
 VideoSurface::~VideoSurface()
 {
+    delete d->statistics;
+
     if (d->updateHandler)
         g_signal_handler_disconnect(d->videoSink, d->updateHandler);
 
@@ -59,11 +61,67 @@ GstElement* VideoSurface::videoSink() const
         Q_ASSERT(G_IS_OBJECT(d->videoSink));
 
         d->updateHandler = g_signal_connect(d->videoSink, "update", G_CALLBACK(updateCallback), (gpointer) this);
+
+        if (g_object_class_find_property(G_OBJECT_GET_CLASS(d->videoSink), "update-node-interface")) {
+            gpointer iface = nullptr;
+            g_object_get(d->videoSink, "update-node-interface", &iface, nullptr);
+            auto updateNodeInterface = static_cast<const GstQtQuick2VideoSinkInterface*>(iface);
+            if (updateNodeInterface && updateNodeInterface->version >= 1)
+                d->updateNodeInterface = updateNodeInterface;
+        }
+
+        // until an item shows it
+        g_object_set(d->videoSink, "visible", d->visibleArea > 0, nullptr);
     }
 
     return d->videoSink;
 }
 
+VideoStatistics* VideoSurface::statistics() const
+{
+    if (!d->statistics) {
+        d->statistics = new VideoStatistics(videoSink(), const_cast<VideoSurface*>(this));
+    }
+
+    return d->statistics;
+}
+
+bool VideoSurface::isVisible() const
+{
+    return d->visibleArea > 0;
+}
+
+qreal VideoSurface::visibleArea() const
+{
+    return d->visibleArea;
+}
+
+void VideoSurface::setItemVisibleArea(VideoItem *item, qreal area)
+{
+    if (area > 0)
+        d->visibleAreas.insert(item, area);
+    else
+        d->visibleAreas.remove(item);
+
+    qreal total = 0;
+    Q_FOREACH(qreal itemArea, d->visibleAreas) {
+        total += itemArea;
+    }
+
+    if (total == d->visibleArea)
+        return;
+
+    const bool wasVisible = isVisible();
+    d->visibleArea = total;
+    Q_EMIT visibleAreaChanged(total);
+
+    if (isVisible() != wasVisible) {
+        if (d->videoSink)
+            g_object_set(d->videoSink, "visible", isVisible(), nullptr);
+        Q_EMIT visibleChanged(isVisible());
+    }
+}
+
 void VideoSurface::onUpdate()
 {
     Q_FOREACH(QQuickItem *item, d->items) {
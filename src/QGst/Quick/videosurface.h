@@ -20,6 +20,7 @@
 
 #include <gst/gstelement.h>
 #include <QObject>
+#include "videostatistics.h"
 
 namespace QGst {
 namespace Quick {
@@ -59,6 +60,9 @@ class VideoSurface : public QObject
 {
     Q_OBJECT
     Q_DISABLE_COPY(VideoSurface)
+    Q_PROPERTY(QGst::Quick::VideoStatistics* statistics READ statistics CONSTANT)
+    Q_PROPERTY(bool visible READ isVisible NOTIFY visibleChanged)
+    Q_PROPERTY(qreal visibleArea READ visibleArea NOTIFY visibleAreaChanged)
 public:
     explicit VideoSurface(QObject *parent = 0);
     virtual ~VideoSurface();
@@ -69,10 +73,33 @@ public:
      */
     GstElement* videoSink() const;
 
+    /*! Returns the rendering statistics of videoSink(), for QML bindings.
+     * The object is owned by the surface.
+     */
+    VideoStatistics* statistics() const;
+
+    /*! Returns whether any of the VideoItems showing this surface is on
+     * screen. The video sink is told, so that it stops drawing while the
+     * surface is hidden; the owner of the pipeline may want to slow it
+     * down or pause it too.
+     */
+    bool isVisible() const;
+
+    /*! Returns how much of the VideoItems showing this surface is on
+     * screen, in device pixels.
+     */
+    qreal visibleArea() const;
+
     void onUpdate();
 
+Q_SIGNALS:
+    void visibleChanged(bool visible);
+    void visibleAreaChanged(qreal area);
+
 private:
     friend class VideoItem;
+    void setItemVisibleArea(VideoItem *item, qreal area);
+
     VideoSurfacePrivate * const d;
 };
 
@@ -20,6 +20,8 @@
 
 #include "videosurface.h"
 #include "videoitem.h"
+#include "../../elements/gstqtvideosink/qtquick2videosinkinterface.h"
+#include <QHash>
 
 namespace QGst {
 namespace Quick {
@@ -28,7 +30,12 @@ class VideoSurfacePrivate
 {
 public:
     QSet<VideoItem*> items;
+    QHash<VideoItem*, qreal> visibleAreas;
+    qreal visibleArea = 0;
     GstElement* videoSink = nullptr;
+    // set if the sink can be called directly instead of through update-node
+    const GstQtQuick2VideoSinkInterface* updateNodeInterface = nullptr;
+    VideoStatistics* statistics = nullptr;
     int updateHandler = 0;
 };
 
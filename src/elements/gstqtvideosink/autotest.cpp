@@ -36,11 +36,29 @@
 # include "painters/openglsurfacepainter.h"
 # include <QOpenGLWidget>
 # include <QGLPixelBuffer>
+# include <QOpenGLContext>
 
 #include "painters/genericsurfacepainter.h"
+#include "utils/seqlock.h"
+#include "utils/renderstatistics.h"
+#include "painters/videoeffect.h"
+#include "utils/colorlookuptable.h"
+#include "painters/softwareconverter.h"
+#include "utils/paralleljpegdecoder.h"
+#include "qtquick2videosinkinterface.h"
+#include <QBuffer>
+#include <QOffscreenSurface>
+#include <QOpenGLFramebufferObject>
+#include <QQuickItem>
+#include <QQuickRenderControl>
+#include <QQuickWindow>
+#include <QRandomGenerator>
 #include <QSignalSpy>
+#include <QReadWriteLock>
+#include <QThread>
 
 Q_DECLARE_METATYPE(Qt::AspectRatioMode)
+Q_DECLARE_METATYPE(VideoEffect::Type)
 
 struct PipelineDeleter
 {
@@ -125,6 +143,54 @@ typedef VideoWidgetT<QOpenGLWidget> VideoGLWidget;
 
 //------------------------------------
 
+// shaped like the sink's DisplayProperties
+struct PropertiesSnapshot
+{
+    PropertiesSnapshot() : a(0), b(0), c(0), d(0), ratio(1, 1), flag(false), version(0) {}
+
+    int a, b, c, d;
+    Fraction ratio;
+    bool flag;
+    quint32 version;
+};
+
+// changes the properties as fast as it can, far more often than any
+// property setter would in practice
+class PropertiesWriter : public QThread
+{
+public:
+    PropertiesWriter(SeqLock<PropertiesSnapshot> *seqLock,
+                     QReadWriteLock *lock, PropertiesSnapshot *locked)
+        : m_seqLock(seqLock), m_lock(lock), m_locked(locked), m_stop(0) {}
+
+    void stop() { m_stop.storeRelease(1); wait(); }
+
+protected:
+    virtual void run()
+    {
+        for (int i = 0; !m_stop.loadAcquire(); i++) {
+            if (m_seqLock) {
+                m_seqLock->modify([i](PropertiesSnapshot &s) {
+                    s.a = s.b = s.c = s.d = i;
+                    s.version++;
+                });
+            } else {
+                QWriteLocker l(m_lock);
+                m_locked->a = m_locked->b = m_locked->c = m_locked->d = i;
+                m_locked->version++;
+            }
+        }
+    }
+
+private:
+    SeqLock<PropertiesSnapshot> *m_seqLock;
+    QReadWriteLock *m_lock;
+    PropertiesSnapshot *m_locked;
+    QAtomicInt m_stop;
+};
+
+//------------------------------------
+
 class QtVideoSinkTest : public QObject
 {
     Q_OBJECT
@@ -147,10 +213,29 @@ private Q_SLOTS:
     void glSurfacePainterFormatsTest_data();
     void glSurfacePainterFormatsTest();
 
+    void propertiesContentionTest_data();
+    void propertiesContentionTest();
+
+    void renderStatisticsTest();
+
+    void effectMaterialTest_data();
+    void effectMaterialTest();
+
+    void colorLookupTableTest();
+
+    void softwareConverterTest();
+
+    void cropMetaTest();
+
+    void parallelJpegDecoderTest();
+
     void cleanupTestCase();
 
 private:
     GstSample *generateTestSample(GstVideoFormat format, int pattern);
+    QImage generateEffectImage(const char *effect, const QSize & size);
+    QImage renderSinkImage(const QByteArray & description, const QSize & size);
+    int effectDifferences(const QImage & result, const QImage & expected);
     GstPipeline *constructPipeline(GstCaps *caps, GstCaps *fakesinkCaps,
                                    bool forceAspectRatio, void *context);
     void imageCompare(const QImage & image1, const QImage & image2, const QSize & sourceSize);
@@ -421,6 +506,524 @@ void QtVideoSinkTest::genericSurfacePainterFormatsTest()
 
 //------------------------------------
 
+void QtVideoSinkTest::propertiesContentionTest_data()
+{
+    QTest::addColumn<bool>("useSeqLock");
+
+    QTest::newRow("seqlock") << true;
+    QTest::newRow("rwlock") << false;
+}
+
+void QtVideoSinkTest::propertiesContentionTest()
+{
+    QFETCH(bool, useSeqLock);
+
+    SeqLock<PropertiesSnapshot> seqLock;
+    QReadWriteLock lock;
+    PropertiesSnapshot locked;
+
+    PropertiesWriter writer(useSeqLock ? &seqLock : NULL, &lock, &locked);
+    writer.start();
+
+    // what updateNode() does once per frame, under constant writes
+    int torn = 0;
+    QBENCHMARK {
+        for (int i = 0; i < 10000; i++) {
+            PropertiesSnapshot snapshot;
+            if (useSeqLock) {
+                snapshot = seqLock.load();
+            } else {
+                QReadLocker l(&lock);
+                snapshot = locked;
+            }
+
+            if (snapshot.a != snapshot.b || snapshot.b != snapshot.c || snapshot.c != snapshot.d)
+                torn++;
+        }
+    }
+
+    writer.stop();
+    QCOMPARE(torn, 0);
+}
+
+//------------------------------------
+
+void QtVideoSinkTest::renderStatisticsTest()
+{
+    RenderStatistics statistics;
+    QCOMPARE(statistics.latency().average, 0.0);
+    QCOMPARE(statistics.latency().p99, 0.0);
+
+    for (int i = 0; i < 5; i++)
+        statistics.frameReceived();
+    statistics.frameReplaced();
+
+    // 1..100us, one sample per frame, plus a frame without a timestamp
+    for (int i = 1; i <= 100; i++)
+        statistics.frameRendered(i * 1000);
+    statistics.frameRendered(-1);
+
+    QCOMPARE(statistics.framesReceived(), quint64(5));
+    QCOMPARE(statistics.framesReplaced(), quint64(1));
+    QCOMPARE(statistics.framesRendered(), quint64(101));
+    QCOMPARE(statistics.latency().average, 50.5);
+    QCOMPARE(statistics.latency().p99, 99.0);
+
+    // only the most recent samples are kept
+    for (int i = 0; i < 1000; i++)
+        statistics.frameUploaded(2000);
+    QCOMPARE(statistics.uploadTime().average, 2.0);
+    QCOMPARE(statistics.uploadTime().p99, 2.0);
+
+    QCOMPARE(statistics.decodeTime().average, 0.0);
+    statistics.frameDecoded(3000);
+    statistics.frameDecoded(5000);
+    QCOMPARE(statistics.decodeTime().average, 4.0);
+    QCOMPARE(statistics.decodeTime().p99, 5.0);
+}
+
+//------------------------------------
+
+void QtVideoSinkTest::effectMaterialTest_data()
+{
+    QTest::addColumn<VideoEffect::Type>("effect");
+
+    for (int i = VideoEffect::None + 1; i < VideoEffect::Num_Types; i++) {
+        const VideoEffect::Type effect = static_cast<VideoEffect::Type>(i);
+        QTest::newRow(VideoEffect::name(effect)) << effect;
+    }
+}
+
+/* Draws the same frame as the element and through the sink, with the
+ * shaders that VideoMaterial builds: the effect in front of the I420
+ * shader, and the texture transform of a mirrored picture. The reference
+ * results were checked with Mesa's llvmpipe (see the test's environment in
+ * CMakeLists.txt); hardware drivers round trigonometric functions
+ * differently, which moves some edges by a pixel. */
+void QtVideoSinkTest::effectMaterialTest()
+{
+    QFETCH(VideoEffect::Type, effect);
+
+    if (!haveGlsl) {
+        QSKIP_PORT("Skipping because the system does not support GLSL", SkipSingle);
+    }
+
+    GstElementPtr element(gst_element_factory_make(VideoEffect::name(effect), NULL));
+    if (!element) {
+        QSKIP_PORT("Skipping because the element is not installed", SkipSingle);
+    }
+
+    //the plugin as built next to us, rather than whatever is installed
+    gst_registry_scan_path(gst_registry_get(), QTVIDEOSINK_PLUGIN_DIR);
+    GstElementPtr sink(gst_element_factory_make("qtquick2videosink", NULL));
+    if (!sink) {
+        QSKIP_PORT("Skipping because qtquick2videosink was not built", SkipSingle);
+    }
+
+    //both go through the same I420 frame, so that they lose the same chroma
+    const QSize size(160, 120);
+    const QByteArray name(VideoEffect::name(effect));
+    const QByteArray effectChain = "video/x-raw,format=I420 ! videoconvert ! " + name
+            + " ! videoflip method=horizontal-flip";
+    const QImage expected = generateEffectImage(effectChain.constData(), size);
+    const QImage result = renderSinkImage(
+            "videotestsrc ! video/x-raw,format=BGRx,width=" + QByteArray::number(size.width())
+            + ",height=" + QByteArray::number(size.height())
+            + " ! videoconvert ! video/x-raw,format=I420"
+            + " ! qtquick2videosink name=sink sync=false force-aspect-ratio=false mirror=true effect=" + name,
+            size);
+    QVERIFY(!expected.isNull());
+    QVERIFY(!result.isNull());
+    QCOMPARE(result.size(), expected.size());
+
+    const int differences = effectDifferences(result, expected);
+    if (differences > 0) {
+        qWarning("%d of %d pixels differ", differences, size.width() * size.height());
+        QFAIL("Failing due to differences in the compared images");
+    }
+}
+
+/* Counts the pixels of result that the effect cannot explain. The shaders
+ * compute the source coordinates in single precision, the elements in
+ * double, so a coordinate close to a pixel boundary may be truncated to the
+ * neighbouring pixel: a pixel matches if one within a pixel of it in the
+ * expected image is similar. The chroma of the I420 frame is also
+ * interpolated differently by the texture unit and by videoconvert, which
+ * mixes the colours on either side of an edge: a pixel within the range of
+ * the colours around it matches as well. Nothing else is allowed,
+ * since the test runs on llvmpipe (see CMakeLists.txt). */
+int QtVideoSinkTest::effectDifferences(const QImage & result, const QImage & expected)
+{
+    int differences = 0;
+    for (int y = 0; y < result.height(); y++) {
+        for (int x = 0; x < result.width(); x++) {
+            const QRgb pixel = result.pixel(x, y);
+            bool matches = false;
+            int low[3] = { 255, 255, 255 };
+            int high[3] = { 0, 0, 0 };
+
+            for (int j = qMax(0, y - 1); j <= qMin(expected.height() - 1, y + 1) && !matches; j++) {
+                for (int i = qMax(0, x - 1); i <= qMin(expected.width() - 1, x + 1) && !matches; i++) {
+                    const QRgb around = expected.pixel(i, j);
+                    matches = pixelsSimilar(pixel, around);
+
+                    const int channels[3] = { qRed(around), qGreen(around), qBlue(around) };
+                    for (int c = 0; c < 3; c++) {
+                        low[c] = qMin(low[c], channels[c]);
+                        high[c] = qMax(high[c], channels[c]);
+                    }
+                }
+            }
+
+            if (!matches) {
+                const int channels[3] = { qRed(pixel), qGreen(pixel), qBlue(pixel) };
+                matches = true;
+                for (int c = 0; c < 3; c++)
+                    matches = matches && channels[c] >= low[c] - 5 && channels[c] <= high[c] + 5;
+            }
+
+            if (!matches)
+                differences++;
+        }
+    }
+    return differences;
+}
+
+//the part of QGst::Quick::VideoItem that matters here
+class SinkItem : public QQuickItem
+{
+public:
+    SinkItem(GstElement *sink, QQuickItem *parent)
+        : QQuickItem(parent), m_sink(sink), m_interface(NULL)
+    {
+        setFlag(ItemHasContents, true);
+        gpointer iface = NULL;
+        g_object_get(sink, "update-node-interface", &iface, NULL);
+        m_interface = static_cast<const GstQtQuick2VideoSinkInterface*>(iface);
+    }
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *)
+    {
+        const QRectF r = boundingRect();
+        return static_cast<QSGNode*>(m_interface->update_node(m_sink, oldNode,
+                                                              r.x(), r.y(), r.width(), r.height()));
+    }
+
+private:
+    GstElement *m_sink;
+    const GstQtQuick2VideoSinkInterface *m_interface;
+};
+
+/* The preroll frame of a pipeline ending in qtquick2videosink, as the
+ * Qt Quick scene graph draws it offscreen over the whole given size. */
+QImage QtVideoSinkTest::renderSinkImage(const QByteArray & description, const QSize & size)
+{
+    GError *error = NULL;
+    GstPipelinePtr pipeline(GST_PIPELINE(gst_parse_launch(description.constData(), &error)));
+    if (error) {
+        qWarning("Failed to construct %s: %s", description.constData(), error->message);
+        g_error_free(error);
+        return QImage();
+    }
+    GstElementPtr sink(gst_bin_get_by_name(GST_BIN(pipeline.data()), "sink"));
+
+    QOpenGLContext context;
+    QOffscreenSurface surface;
+    if (!context.create())
+        return QImage();
+    surface.setFormat(context.format());
+    surface.create();
+    if (!context.makeCurrent(&surface))
+        return QImage();
+
+    QImage image;
+    {
+        QQuickRenderControl renderControl;
+        QQuickWindow window(&renderControl);
+        window.setGeometry(QRect(QPoint(), size));
+        renderControl.initialize(&context);
+
+        QOpenGLFramebufferObject fbo(size, QOpenGLFramebufferObject::CombinedDepthStencil);
+        window.setRenderTarget(&fbo);
+
+        SinkItem *item = new SinkItem(sink.data(), window.contentItem());
+        item->setSize(size);
+
+        gst_element_set_state(GST_ELEMENT(pipeline.data()), GST_STATE_PAUSED);
+        GstState state = GST_STATE_NULL;
+        if (gst_element_get_state(GST_ELEMENT(pipeline.data()), &state, NULL, 10 * GST_SECOND)
+                == GST_STATE_CHANGE_SUCCESS && state == GST_STATE_PAUSED) {
+            //delivers the sink's update request
+            QCoreApplication::processEvents();
+            item->update();
+            renderControl.polishItems();
+            renderControl.sync();
+            renderControl.render();
+            image = fbo.toImage().convertToFormat(QImage::Format_RGB32);
+        } else {
+            QWARN("Failed to set the sink pipeline to PAUSED");
+        }
+
+        gst_element_set_state(GST_ELEMENT(pipeline.data()), GST_STATE_NULL);
+        delete item;
+        renderControl.invalidate();
+    }
+    context.doneCurrent();
+    return image;
+}
+
+//------------------------------------
+
+void QtVideoSinkTest::colorLookupTableTest()
+{
+    GError *error = NULL;
+    QVERIFY(!ColorLookupTable::bake("nosuchelement", 9, &error));
+    QVERIFY(error);
+    g_clear_error(&error);
+
+    // the lattice comes back as it went in
+    ColorLookupTable::Ptr table = ColorLookupTable::bake("identity", 9, &error);
+    QVERIFY2(table, error ? error->message : "");
+    QCOMPARE(table->size(), 9);
+    QCOMPARE(table->data().size(), 9 * 9 * 9 * 4);
+
+    const quint8 *texel = reinterpret_cast<const quint8 *>(table->data().constData());
+    for (int g = 0; g < 9; g++) {
+        for (int b = 0; b < 9; b++) {
+            for (int r = 0; r < 9; r++, texel += 4) {
+                QCOMPARE(int(texel[0]), (r * 255 + 4) / 8);
+                QCOMPARE(int(texel[1]), (g * 255 + 4) / 8);
+                QCOMPARE(int(texel[2]), (b * 255 + 4) / 8);
+            }
+        }
+    }
+
+    GstElementPtr videobalance(gst_element_factory_make("videobalance", NULL));
+    if (!videobalance) {
+        QSKIP_PORT("Skipping the rest because videobalance is not installed", SkipSingle);
+    }
+
+    // every colour turns grey, give or take the rounding of the conversions
+    table = ColorLookupTable::bake("videobalance saturation=0", 9, &error);
+    QVERIFY2(table, error ? error->message : "");
+
+    texel = reinterpret_cast<const quint8 *>(table->data().constData());
+    for (int i = 0; i < 9 * 9 * 9; i++, texel += 4) {
+        QVERIFY(qAbs(texel[0] - texel[1]) <= 2);
+        QVERIFY(qAbs(texel[1] - texel[2]) <= 2);
+    }
+}
+
+//------------------------------------
+
+void QtVideoSinkTest::softwareConverterTest()
+{
+    // whatever the CPU runs must give exactly what the plain kernel gives
+    QRandomGenerator rng(1);
+    SoftwareConverter::Coefficients k;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++)
+            k.matrix[row][column] = rng.bounded(-8192, 8192);
+        k.offset[row] = rng.bounded(-(1 << 21), 1 << 21);
+    }
+
+    const int width = 77;
+    quint8 components[3][width];
+    for (int c = 0; c < 3; c++) {
+        for (int i = 0; i < width; i++)
+            components[c][i] = rng.bounded(256);
+    }
+
+    quint32 expected[width], actual[width];
+    SoftwareConverter::scalarRowFunction()(components[0], components[1], components[2],
+                                           expected, width, k);
+    SoftwareConverter::rowFunction()(components[0], components[1], components[2],
+                                     actual, width, k);
+    for (int i = 0; i < width; i++)
+        QCOMPARE(actual[i], expected[i]);
+
+    // an I420 frame, red on the left half and blue on the right
+    const QSize size(16, 8);
+    GstCaps *caps = BufferFormat::newCaps(GST_VIDEO_FORMAT_I420, size, Fraction(30, 1), Fraction(1, 1));
+    const BufferFormat format = BufferFormat::fromCaps(caps);
+    gst_caps_unref(caps);
+    QVERIFY(SoftwareConverter::supportsFormat(format.videoFormat()));
+
+    GstVideoInfo info = format.videoInfo();
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, GST_VIDEO_INFO_SIZE(&info), NULL);
+    GstVideoFrame frame;
+    QVERIFY(gst_video_frame_map(&frame, &info, buffer, GST_MAP_WRITE));
+    for (int c = 0; c < 3; c++) {
+        const quint8 red[] = { 81, 90, 240 };
+        const quint8 blue[] = { 41, 240, 110 };
+        quint8 *data = static_cast<quint8*>(GST_VIDEO_FRAME_COMP_DATA(&frame, c));
+        const int componentWidth = GST_VIDEO_FRAME_COMP_WIDTH(&frame, c);
+        for (int y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT(&frame, c); y++) {
+            quint8 *line = data + y * GST_VIDEO_FRAME_COMP_STRIDE(&frame, c);
+            memset(line, red[c], componentWidth / 2);
+            memset(line + componentWidth / 2, blue[c], componentWidth / 2);
+        }
+    }
+    gst_video_frame_unmap(&frame);
+
+    SoftwareConverter converter;
+    QImage image;
+    QVERIFY(converter.convert(buffer, format, QRectF(0, 0, 1, 1), QTransform(), QSize(4, 2), &image));
+    QCOMPARE(image.size(), QSize(4, 2));
+    QVERIFY(pixelsSimilar(image.pixel(0, 0), qRgb(255, 0, 0)));
+    QVERIFY(pixelsSimilar(image.pixel(3, 1), qRgb(0, 0, 255)));
+
+    // mirrored, and with the colors turned off
+    converter.updateColors(0, 0, 0, -100);
+    QVERIFY(converter.convert(buffer, format, QRectF(0, 0, 1, 1),
+                              QTransform(-1, 0, 0, 1, 1, 0), QSize(4, 2), &image));
+    QVERIFY(qGray(image.pixel(0, 0)) < qGray(image.pixel(3, 0)));
+    QCOMPARE(qRed(image.pixel(0, 0)), qGreen(image.pixel(0, 0)));
+
+    gst_buffer_unref(buffer);
+}
+
+//------------------------------------
+
+void QtVideoSinkTest::cropMetaTest()
+{
+    // the caps say 16x8, but the frames come whole at 32x16 with the part
+    // to show in the middle: red, with blue around it
+    const QRect crop(8, 4, 16, 8);
+    GstCaps *caps = BufferFormat::newCaps(GST_VIDEO_FORMAT_I420, crop.size(), Fraction(30, 1), Fraction(1, 1));
+    const BufferFormat format = BufferFormat::fromCaps(caps);
+    gst_caps_unref(caps);
+
+    GstVideoInfo info;
+    gst_video_info_set_format(&info, GST_VIDEO_FORMAT_I420, 32, 16);
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, GST_VIDEO_INFO_SIZE(&info), NULL);
+    gst_buffer_add_video_meta_full(buffer, GST_VIDEO_FRAME_FLAG_NONE, GST_VIDEO_FORMAT_I420, 32, 16,
+                                   GST_VIDEO_INFO_N_PLANES(&info), info.offset, info.stride);
+
+    GstVideoFrame frame;
+    QVERIFY(gst_video_frame_map(&frame, &info, buffer, GST_MAP_WRITE));
+    for (int c = 0; c < 3; c++) {
+        const quint8 red[] = { 81, 90, 240 };
+        const quint8 blue[] = { 41, 240, 110 };
+        const int scaleX = 32 / GST_VIDEO_FRAME_COMP_WIDTH(&frame, c);
+        const int scaleY = 16 / GST_VIDEO_FRAME_COMP_HEIGHT(&frame, c);
+        quint8 *data = static_cast<quint8*>(GST_VIDEO_FRAME_COMP_DATA(&frame, c));
+        for (int y = 0; y < GST_VIDEO_FRAME_COMP_HEIGHT(&frame, c); y++) {
+            quint8 *line = data + y * GST_VIDEO_FRAME_COMP_STRIDE(&frame, c);
+            for (int x = 0; x < GST_VIDEO_FRAME_COMP_WIDTH(&frame, c); x++)
+                line[x] = crop.contains(x * scaleX, y * scaleY) ? red[c] : blue[c];
+        }
+    }
+    gst_video_frame_unmap(&frame);
+
+    // what the delegate gets for such a frame
+    const BufferFormat padded = format.withFrameSize(QSize(32, 16));
+    QCOMPARE(padded.frameSize(), QSize(32, 16));
+    QCOMPARE(padded.videoFormat(), GST_VIDEO_FORMAT_I420);
+    QCOMPARE(padded.visibleRect(buffer), QRect(QPoint(), crop.size()));
+
+    gst_buffer_add_video_crop_meta(buffer);
+    GstVideoCropMeta *cropMeta = gst_buffer_get_video_crop_meta(buffer);
+    cropMeta->x = crop.x();
+    cropMeta->y = crop.y();
+    cropMeta->width = crop.width();
+    cropMeta->height = crop.height();
+    QCOMPARE(padded.visibleRect(buffer), crop);
+
+    const QTransform transform = padded.cropTransform(crop);
+    QCOMPARE(transform.map(QPointF(0, 0)), QPointF(0.25, 0.25));
+    QCOMPARE(transform.map(QPointF(1, 1)), QPointF(0.75, 0.75));
+
+    // only the red part is drawn
+    SoftwareConverter converter;
+    QImage image;
+    QVERIFY(converter.convert(buffer, padded, QRectF(0, 0, 1, 1), transform, crop.size(), &image));
+    QCOMPARE(image.size(), crop.size());
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width(); x++)
+            QVERIFY(pixelsSimilar(image.pixel(x, y), qRgb(255, 0, 0)));
+    }
+
+    gst_buffer_unref(buffer);
+}
+
+//------------------------------------
+
+static GstBuffer *bufferWithCopy(const void *data, gsize size)
+{
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, size, NULL);
+    gst_buffer_fill(buffer, 0, data, size);
+    return buffer;
+}
+
+static GstBuffer *jpegBuffer(const QImage & image)
+{
+    QByteArray data;
+    QBuffer device(&data);
+    device.open(QIODevice::WriteOnly);
+    image.save(&device, "JPEG", 95);
+    return bufferWithCopy(data.constData(), data.size());
+}
+
+void QtVideoSinkTest::parallelJpegDecoderTest()
+{
+    // frames of different shades, so that any reordering shows
+    const int frames = 24;
+    QList<GstBuffer*> input;
+    for (int i = 0; i < frames; i++) {
+        QImage image(64, 48, QImage::Format_RGB32);
+        image.fill(qRgb(i * 10, 255 - i * 10, 128));
+        input << jpegBuffer(image);
+    }
+    const char garbage[] = "not a JPEG";
+    input.insert(frames / 2, bufferWithCopy(garbage, sizeof(garbage)));
+
+    ParallelJpegDecoder decoder(3);
+    QCOMPARE(decoder.threads(), 3);
+
+    QList<ParallelJpegDecoder::Frame> output;
+    ParallelJpegDecoder::Frame frame;
+    Q_FOREACH(GstBuffer *buffer, input) {
+        decoder.push(buffer);
+        while (decoder.take(&frame, decoder.pending() > decoder.threads()))
+            output << frame;
+        QVERIFY(decoder.pending() <= decoder.threads());
+    }
+    while (decoder.take(&frame, true))
+        output << frame;
+    QCOMPARE(decoder.pending(), 0);
+
+    QCOMPARE(output.size(), input.size());
+    for (int i = 0; i < output.size(); i++) {
+        QCOMPARE(output[i].buffer, input[i]);
+        gst_buffer_unref(output[i].buffer);
+        gst_buffer_unref(input[i]);
+
+        if (i == frames / 2) {
+            QVERIFY(output[i].image.isNull());
+            continue;
+        }
+
+        const int shade = (i < frames / 2 ? i : i - 1) * 10;
+        QCOMPARE(output[i].image.format(), QImage::Format_RGB32);
+        QCOMPARE(output[i].image.size(), QSize(64, 48));
+        QVERIFY(pixelsSimilar(output[i].image.pixel(32, 24), qRgb(shade, 255 - shade, 128)));
+        QVERIFY(output[i].decodeTime > 0);
+    }
+
+    // what is left at a flush is dropped
+    GstBuffer *buffer = jpegBuffer(QImage(16, 16, QImage::Format_RGB32));
+    decoder.push(buffer);
+    decoder.push(buffer);
+    decoder.flush();
+    QCOMPARE(decoder.pending(), 0);
+    QCOMPARE(GST_MINI_OBJECT_REFCOUNT_VALUE(buffer), 1);
+    gst_buffer_unref(buffer);
+}
+
+//------------------------------------
+
 void QtVideoSinkTest::glSurfacePainterFormatsTest_data()
 {
     QTest::addColumn<GstVideoFormat>("format");
@@ -626,6 +1229,54 @@ GstSample* QtVideoSinkTest::generateTestSample(GstVideoFormat format, int patter
     return samplePtr;
 }
 
+/* A frame of videotestsrc's default pattern as it comes out of the
+ * given element, in the same format the sink would get it. */
+QImage QtVideoSinkTest::generateEffectImage(const char *effect, const QSize & size)
+{
+    const QByteArray description = QByteArray("videotestsrc ! video/x-raw,format=BGRx,width=")
+            + QByteArray::number(size.width()) + ",height=" + QByteArray::number(size.height())
+            + " ! videoconvert ! " + effect + " ! videoconvert ! video/x-raw,format=BGRx"
+            + " ! fakesink name=sink enable-last-sample=true";
+
+    GError *error = NULL;
+    GstPipelinePtr pipeline(GST_PIPELINE(gst_parse_launch(description.constData(), &error)));
+    if (error) {
+        qWarning("Failed to construct %s: %s", description.constData(), error->message);
+        g_error_free(error);
+        return QImage();
+    }
+
+    gst_element_set_state(GST_ELEMENT(pipeline.data()), GST_STATE_PAUSED);
+
+    GstState state = GST_STATE_NULL;
+    GstStateChangeReturn stateReturn = gst_element_get_state(GST_ELEMENT(pipeline.data()),
+                                                             &state, NULL, 10 * GST_SECOND);
+    if (stateReturn != GST_STATE_CHANGE_SUCCESS || state != GST_STATE_PAUSED) {
+        QWARN("Failed to set the effect pipeline to PAUSED");
+        return QImage();
+    }
+
+    GstElementPtr fakesink(gst_bin_get_by_name(GST_BIN(pipeline.data()), "sink"));
+    GstSample *samplePtr = NULL;
+    g_object_get(fakesink.data(), "last-sample", &samplePtr, NULL);
+    GstSamplePtr sample(samplePtr);
+    if (!sample) {
+        return QImage();
+    }
+
+    GstMapInfo info;
+    GstBuffer *buffer = gst_sample_get_buffer(sample.data());
+    if (!buffer || !gst_buffer_map(buffer, &info, GST_MAP_READ)) {
+        return QImage();
+    }
+
+    //BGRx is what QImage calls RGB32 on little endian machines
+    const QImage image = QImage(info.data, size.width(), size.height(),
+                                size.width() * 4, QImage::Format_RGB32).copy();
+    gst_buffer_unmap(buffer, &info);
+    return image;
+}
+
 GstPipeline *QtVideoSinkTest::constructPipeline(GstCaps *caps,
         GstCaps *fakesinkCaps, bool forceAspectRatio, void *context)
 {
@@ -0,0 +1,308 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Renders qtquick2videosink offscreen, as fast as it can, for every
+ * format it accepts and a few common sizes, and prints one CSV line per
+ * run. Meant to be compared before and after changes to the painters:
+ *
+ *   qtvideosink_bench --frames 300 > before.csv
+ *
+ * Unless told otherwise, it uses the offscreen platform plugin and Mesa's
+ * software rasterizer, so that the numbers do not depend on the GPU. */
+
+#include "qtquick2videosinkinterface.h"
+
+#include <gst/gst.h>
+
+#include <QGuiApplication>
+#include <QCommandLineParser>
+#include <QElapsedTimer>
+#include <QOffscreenSurface>
+#include <QOpenGLContext>
+#include <QOpenGLFramebufferObject>
+#include <QOpenGLFunctions>
+#include <QQuickItem>
+#include <QQuickRenderControl>
+#include <QQuickWindow>
+#include <QTextStream>
+
+//the same as CAPS_FORMATS in gstqtquick2videosink.cpp
+static const char * const s_formats[] = {
+    "BGRA", "BGRx", "ARGB", "xRGB", "RGB", "RGB16", "BGR", "v308", "AYUV",
+    "YV12", "I420", "YUY2", "UYVY", "YVYU", "NV12", "NV21", "Y42B", "Y444", "GRAY8"
+};
+
+static const QSize s_sizes[] = {
+    QSize(320, 240), QSize(640, 480), QSize(1280, 720), QSize(1920, 1080)
+};
+
+//the part of QGst::Quick::VideoItem that matters here
+class BenchItem : public QQuickItem
+{
+public:
+    explicit BenchItem(QQuickItem *parent = nullptr)
+        : QQuickItem(parent), m_sink(nullptr), m_interface(nullptr)
+    {
+        setFlag(ItemHasContents, true);
+    }
+
+    void setSink(GstElement *sink)
+    {
+        m_sink = sink;
+        gpointer iface = nullptr;
+        g_object_get(sink, "update-node-interface", &iface, nullptr);
+        m_interface = static_cast<const GstQtQuick2VideoSinkInterface*>(iface);
+    }
+
+protected:
+    QSGNode *updatePaintNode(QSGNode *oldNode, UpdatePaintNodeData *) override
+    {
+        if (!m_interface)
+            return oldNode;
+
+        const QRectF r = boundingRect();
+        return static_cast<QSGNode*>(m_interface->update_node(m_sink, oldNode,
+                                                              r.x(), r.y(), r.width(), r.height()));
+    }
+
+private:
+    GstElement *m_sink;
+    const GstQtQuick2VideoSinkInterface *m_interface;
+};
+
+class Bench
+{
+public:
+    Bench(const QSize & viewSize)
+        : m_viewSize(viewSize), m_item(nullptr), m_fbo(nullptr), m_newFrame(false)
+    {
+    }
+
+    ~Bench()
+    {
+        if (m_context.makeCurrent(&m_surface)) {
+            m_renderControl.invalidate();
+            delete m_fbo;
+            m_context.doneCurrent();
+        }
+    }
+
+    bool init()
+    {
+        QSurfaceFormat format;
+        format.setDepthBufferSize(16);
+        format.setStencilBufferSize(8);
+
+        m_context.setFormat(format);
+        if (!m_context.create())
+            return false;
+
+        m_surface.setFormat(m_context.format());
+        m_surface.create();
+        if (!m_context.makeCurrent(&m_surface))
+            return false;
+
+        m_window.reset(new QQuickWindow(&m_renderControl));
+        m_window->setGeometry(QRect(QPoint(), m_viewSize));
+        m_renderControl.initialize(&m_context);
+
+        m_fbo = new QOpenGLFramebufferObject(m_viewSize,
+                                             QOpenGLFramebufferObject::CombinedDepthStencil);
+        m_window->setRenderTarget(m_fbo);
+
+        m_item = new BenchItem(m_window->contentItem());
+        m_item->setSize(m_viewSize);
+        return true;
+    }
+
+    //one line of CSV, or an empty string if the pipeline failed
+    QString run(const char *format, const QSize & size, int frames)
+    {
+        const QByteArray description = QByteArrayLiteral("videotestsrc pattern=smpte num-buffers=")
+                + QByteArray::number(frames)
+                + " ! video/x-raw,format=" + format
+                + ",width=" + QByteArray::number(size.width())
+                + ",height=" + QByteArray::number(size.height())
+                + ",framerate=1000/1 ! qtquick2videosink name=sink sync=false qos=false";
+
+        GError *error = nullptr;
+        GstElement *pipeline = gst_parse_launch(description.constData(), &error);
+        if (!pipeline) {
+            qWarning("%s", error->message);
+            g_error_free(error);
+            return QString();
+        }
+
+        GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+        m_item->setSink(sink);
+        const gulong handler = g_signal_connect(sink, "update", G_CALLBACK(onUpdate), this);
+
+        qint64 renderNs = 0;
+        int renders = 0;
+        bool ok = true;
+
+        QElapsedTimer timer;
+        timer.start();
+        gst_element_set_state(pipeline, GST_STATE_PLAYING);
+
+        GstBus *bus = gst_element_get_bus(pipeline);
+        for (;;) {
+            //delivers the sink's update signal
+            QCoreApplication::processEvents();
+
+            if (m_newFrame) {
+                m_newFrame = false;
+                m_item->update();
+                renderNs += render();
+                renders++;
+            }
+
+            GstMessage *message = gst_bus_timed_pop_filtered(bus, m_newFrame ? 0 : 100 * GST_USECOND,
+                    static_cast<GstMessageType>(GST_MESSAGE_EOS | GST_MESSAGE_ERROR));
+            if (message) {
+                ok = (GST_MESSAGE_TYPE(message) == GST_MESSAGE_EOS);
+                if (!ok) {
+                    gst_message_parse_error(message, &error, nullptr);
+                    qWarning("%s: %s", format, error->message);
+                    g_error_free(error);
+                }
+                gst_message_unref(message);
+                break;
+            }
+        }
+        const qint64 elapsedNs = timer.nsecsElapsed();
+        gst_object_unref(bus);
+
+        guint64 rendered = 0;
+        guint replaced = 0;
+        gdouble uploadTime = 0;
+        g_object_get(sink, "frames-rendered", &rendered, "replaced-frames", &replaced,
+                     "upload-time-average", &uploadTime, nullptr);
+
+        g_signal_handler_disconnect(sink, handler);
+        gst_element_set_state(pipeline, GST_STATE_NULL);
+
+        //the node belongs to this sink; let the next one make its own
+        delete m_item;
+        m_item = new BenchItem(m_window->contentItem());
+        m_item->setSize(m_viewSize);
+        render();
+
+        gst_object_unref(sink);
+        gst_object_unref(pipeline);
+
+        if (!ok)
+            return QString();
+
+        return QStringLiteral("%1,%2,%3,%4,%5,%6,%7,%8")
+                .arg(QLatin1String(format))
+                .arg(size.width()).arg(size.height())
+                .arg(rendered).arg(replaced)
+                .arg(rendered * 1e9 / elapsedNs, 0, 'f', 1)
+                .arg(uploadTime, 0, 'f', 1)
+                .arg(renders ? renderNs / 1000.0 / renders : 0, 0, 'f', 1);
+    }
+
+private:
+    static void onUpdate(GstElement *, Bench *bench)
+    {
+        bench->m_newFrame = true;
+    }
+
+    //what the render thread does for a frame, until the GPU is done with it
+    qint64 render()
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        m_renderControl.polishItems();
+        m_renderControl.sync();
+        m_renderControl.render();
+        m_context.functions()->glFinish();
+
+        return timer.nsecsElapsed();
+    }
+
+    const QSize m_viewSize;
+    QOpenGLContext m_context;
+    QOffscreenSurface m_surface;
+    QScopedPointer<QQuickWindow> m_window;
+    QQuickRenderControl m_renderControl;
+    BenchItem *m_item;
+    QOpenGLFramebufferObject *m_fbo;
+    bool m_newFrame;
+};
+
+int main(int argc, char *argv[])
+{
+    if (qEnvironmentVariableIsEmpty("QT_QPA_PLATFORM"))
+        qputenv("QT_QPA_PLATFORM", "offscreen");
+    if (qEnvironmentVariableIsEmpty("LIBGL_ALWAYS_SOFTWARE"))
+        qputenv("LIBGL_ALWAYS_SOFTWARE", "1");
+
+    QGuiApplication app(argc, argv);
+    gst_init(&argc, &argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures how fast qtquick2videosink renders"));
+    parser.addHelpOption();
+    QCommandLineOption framesOption(QStringLiteral("frames"),
+            QStringLiteral("Frames to feed for each format and size"), QStringLiteral("count"),
+            QStringLiteral("200"));
+    QCommandLineOption formatOption(QStringLiteral("format"),
+            QStringLiteral("Only measure this format; may be repeated"), QStringLiteral("format"));
+    parser.addOption(framesOption);
+    parser.addOption(formatOption);
+    parser.process(app);
+
+    const int frames = qMax(1, parser.value(framesOption).toInt());
+    const QStringList onlyFormats = parser.values(formatOption);
+
+    //the plugin as built next to us, rather than whatever is installed
+    gst_registry_scan_path(gst_registry_get(), QTVIDEOSINK_PLUGIN_DIR);
+    if (!gst_registry_check_feature_version(gst_registry_get(), "qtquick2videosink",
+                                            GST_VERSION_MAJOR, GST_VERSION_MINOR, 0)) {
+        qCritical("qtquick2videosink was not found in " QTVIDEOSINK_PLUGIN_DIR);
+        return 1;
+    }
+
+    Bench bench(QSize(1280, 720));
+    if (!bench.init()) {
+        qCritical("Failed to set up an OpenGL context");
+        return 1;
+    }
+
+    QTextStream out(stdout);
+    out << "format,width,height,frames_rendered,frames_replaced,fps,upload_us,render_us" << endl;
+
+    int failures = 0;
+    for (const char *format : s_formats) {
+        if (!onlyFormats.isEmpty() && !onlyFormats.contains(QLatin1String(format)))
+            continue;
+
+        for (const QSize & size : s_sizes) {
+            const QString line = bench.run(format, size, frames);
+            if (line.isEmpty()) {
+                failures++;
+                continue;
+            }
+            out << line << endl;
+        }
+    }
+
+    gst_deinit();
+    return failures ? 1 : 0;
+}
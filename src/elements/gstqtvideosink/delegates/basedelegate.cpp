@@ -16,22 +16,24 @@
 */
 
 #include "basedelegate.h"
+#include "../utils/decodetimemeta.h"
 
+#include <gst/base/gstbasesink.h>
+#include <gst/video/gstvideometa.h>
 #include <QCoreApplication>
 
 BaseDelegate::BaseDelegate(GstElement * sink, QObject * parent)
     : QObject(parent)
-    , m_colorsDirty(true)
-    , m_brightness(0)
-    , m_contrast(0)
-    , m_hue(0)
-    , m_saturation(0)
-    , m_pixelAspectRatio(1, 1)
-    , m_forceAspectRatioDirty(true)
-    , m_forceAspectRatio(false)
-    , m_formatDirty(true)
-    , m_isActive(false)
+    , m_isActive(0)
     , m_buffer(NULL)
+    , m_pendingFrame(NULL)
+    , m_updatePending(0)
+    , m_pacingLatency(0)
+    , m_visible(1)
+    , m_statistics(new RenderStatistics)
+    , m_qos(1)
+    , m_qosProportion(1.0)
+    , m_qosFramesReceived(0)
     , m_sink(sink)
 {
 }
@@ -39,153 +41,550 @@ BaseDelegate::BaseDelegate(GstElement * sink, QObject * parent)
 BaseDelegate::~BaseDelegate()
 {
     Q_ASSERT(!isActive());
+    delete m_pendingFrame.fetchAndStoreOrdered(NULL);
+    dropPacedFrames();
+    gst_buffer_replace(&m_buffer, NULL);
 }
 
 //-------------------------------------
 
 bool BaseDelegate::isActive() const
 {
-    QReadLocker l(&m_isActiveLock);
-    return m_isActive;
+    return m_isActive.loadAcquire();
 }
 
 void BaseDelegate::setActive(bool active)
 {
     GST_INFO_OBJECT(m_sink, active ? "Activating" : "Deactivating");
 
-    QWriteLocker l(&m_isActiveLock);
-    m_isActive = active;
-    if (!active) {
+    m_isActive.storeRelease(active);
+    if (active) {
+        // left over from before the last deactivation
+        delete m_pendingFrame.fetchAndStoreOrdered(NULL);
+        dropPacedFrames();
+    } else {
         QCoreApplication::postEvent(this, new DeactivateEvent());
     }
 }
 
 //-------------------------------------
 
+void BaseDelegate::setStreamFormat(const BufferFormat & format)
+{
+    m_streamFormat = format;
+    m_paddedFormat = BufferFormat();
+}
+
+/* Upstream may hand over frames that are larger in memory than the caps
+ * say, e.g. a decoder's padded frames or the whole frame from videocrop.
+ * The textures then hold all of it and the crop meta or the caps size
+ * tell which part is shown. */
+BufferFormat BaseDelegate::frameFormat(GstBuffer *buffer)
+{
+    const GstVideoMeta *meta = gst_buffer_get_video_meta(buffer);
+    if (!meta)
+        return m_streamFormat;
+
+    const QSize size(meta->width, meta->height);
+    if (size == m_streamFormat.frameSize())
+        return m_streamFormat;
+
+    if (m_paddedFormat.frameSize() != size)
+        m_paddedFormat = m_streamFormat.withFrameSize(size);
+    return m_paddedFormat;
+}
+
+/* Frames do not travel through the GUI thread's event queue. The
+ * streaming thread leaves the latest one in a single slot, which the
+ * render thread empties while it syncs with the items. The GUI thread is
+ * still needed to schedule that sync, since QQuickItem::update() may only
+ * be called from there, but at most one such request is queued at a time.
+ * A stalled GUI thread thus delays the next picture without piling up
+ * stale frames, and the render thread always gets the newest one. */
+void BaseDelegate::pushBuffer(GstBuffer *buffer, GstClockTime runningTime)
+{
+    m_statistics->frameReceived();
+
+    // set by qtjpegdec
+    const GstQtDecodeTimeMeta *decodeTime = gst_buffer_get_qt_decode_time_meta(buffer);
+    if (decodeTime && GST_CLOCK_TIME_IS_VALID(decodeTime->decode_time))
+        m_statistics->frameDecoded(decodeTime->decode_time);
+
+    Frame *frame = new Frame(buffer, frameFormat(buffer), runningTime);
+    Frame *old = NULL;
+
+    // nobody looks at a hidden sink, so it neither paces nor asks for
+    // updates; the latest frame is shown as soon as it is visible again
+    if (isVisible() && pacingLatency()) {
+        QMutexLocker l(&m_pacedFramesMutex);
+        m_pacedFrames.append(frame);
+        if (m_pacedFrames.size() > Max_Paced_Frames)
+            old = m_pacedFrames.takeFirst();
+    } else {
+        old = m_pendingFrame.fetchAndStoreOrdered(frame);
+    }
+
+    if (old) {
+        GST_LOG_OBJECT(m_sink, "Buffer %" GST_PTR_FORMAT " replaced before being displayed",
+                       old->buffer);
+        m_statistics->frameReplaced();
+        delete old;
+    }
+
+    // read again, in case the sink was shown meanwhile and did not see
+    // this frame yet
+    if (isVisible())
+        requestUpdate();
+}
+
+void BaseDelegate::requestUpdate()
+{
+    if (m_updatePending.testAndSetOrdered(0, 1)) {
+        QCoreApplication::postEvent(this,
+            new QEvent(static_cast<QEvent::Type>(UpdateEventType)));
+    }
+}
+
+/* GstBaseSink hands the frames over pacing-latency ahead of their time
+ * (that is its render-delay), so there is normally a frame or two waiting
+ * here. The one shown is the last that is due when the picture reaches
+ * the screen, and the ones before it are dropped. Until then, the items
+ * are synced on every refresh, so that each frame appears on the vsync
+ * closest to its timestamp rather than whenever the scene graph happens
+ * to render. */
+BaseDelegate::Frame *BaseDelegate::takePacedFrame(GstClockTime refreshInterval)
+{
+    // while paused, e.g. for the preroll frame, the clock tells nothing
+    GstClockTime displayTime = GST_CLOCK_TIME_NONE;
+    GstClock *clock = gst_element_get_clock(m_sink);
+    if (clock && GST_STATE(m_sink) == GST_STATE_PLAYING) {
+        const GstClockTime now = gst_clock_get_time(clock);
+        const GstClockTime baseTime = gst_element_get_base_time(m_sink);
+        if (now >= baseTime)
+            displayTime = now - baseTime + refreshInterval;
+    }
+    if (clock)
+        gst_object_unref(clock);
+
+    QMutexLocker l(&m_pacedFramesMutex);
+
+    Frame *frame = NULL;
+    while (!m_pacedFrames.isEmpty()) {
+        const GstClockTime runningTime = m_pacedFrames.first()->runningTime;
+
+        // without a clock or timestamps, there is nothing to wait for
+        if (GST_CLOCK_TIME_IS_VALID(displayTime) && GST_CLOCK_TIME_IS_VALID(runningTime)
+            && runningTime > displayTime) {
+            break;
+        }
+
+        if (frame) {
+            m_statistics->frameReplaced();
+            delete frame;
+        }
+        frame = m_pacedFrames.takeFirst();
+    }
+
+    if (!m_pacedFrames.isEmpty())
+        requestUpdate();
+
+    return frame;
+}
+
+void BaseDelegate::dropPacedFrames()
+{
+    QMutexLocker l(&m_pacedFramesMutex);
+    qDeleteAll(m_pacedFrames);
+    m_pacedFrames.clear();
+}
+
+bool BaseDelegate::takeFrame(GstClockTime refreshInterval)
+{
+    // the mailbox may still hold a frame from before pacing was turned on
+    Frame *frame = m_pendingFrame.fetchAndStoreOrdered(NULL);
+    if (!frame)
+        frame = takePacedFrame(refreshInterval);
+    if (!frame)
+        return false;
+
+    // frames still arriving while the sink is stopping are dropped
+    if (isActive()) {
+        GST_TRACE_OBJECT(m_sink, "Taking buffer %" GST_PTR_FORMAT, frame->buffer);
+
+        m_bufferFormat = frame->format;
+        gst_buffer_replace(&m_buffer, frame->buffer);
+
+        // the frame is drawn in the render pass that follows this sync
+        GstClockTimeDiff diff;
+        if (jitter(frame->runningTime, &diff)) {
+            m_statistics->frameRendered(qMax<GstClockTimeDiff>(diff, 0));
+            sendQos(frame->runningTime, diff);
+        } else {
+            m_statistics->frameRendered(-1);
+        }
+    }
+
+    delete frame;
+    return true;
+}
+
+bool BaseDelegate::jitter(GstClockTime runningTime, GstClockTimeDiff *jitter) const
+{
+    if (!GST_CLOCK_TIME_IS_VALID(runningTime))
+        return false;
+
+    GstClock *clock = gst_element_get_clock(m_sink);
+    if (!clock)
+        return false;
+
+    // the base time of now, not of when the buffer arrived, in case the
+    // pipeline was paused in between
+    const GstClockTime renderTime = runningTime + gst_element_get_base_time(m_sink);
+    *jitter = GST_CLOCK_DIFF(renderTime, gst_clock_get_time(clock));
+    gst_object_unref(clock);
+
+    return true;
+}
+
+bool BaseDelegate::isVisible() const
+{
+    return m_visible.loadAcquire();
+}
+
+void BaseDelegate::setVisible(bool visible)
+{
+    if (m_visible.fetchAndStoreOrdered(visible) == int(visible))
+        return;
+
+    GST_DEBUG_OBJECT(m_sink, visible ? "Shown" : "Hidden");
+
+    if (!visible) {
+        // frames waiting for their time would only get stale
+        dropPacedFrames();
+    } else if (m_pendingFrame.loadAcquire()) {
+        requestUpdate();
+    }
+}
+
+GstClockTime BaseDelegate::pacingLatency() const
+{
+    return m_pacingLatency.loadAcquire();
+}
+
+void BaseDelegate::setPacingLatency(GstClockTime latency)
+{
+    if (m_pacingLatency.fetchAndStoreOrdered(latency) == latency)
+        return;
+
+    // frames come that much earlier, and the pipeline has to know
+    gst_base_sink_set_render_delay(GST_BASE_SINK(m_sink), latency);
+    gst_element_post_message(m_sink, gst_message_new_latency(GST_OBJECT(m_sink)));
+}
+
+bool BaseDelegate::qos() const
+{
+    return m_qos.loadAcquire();
+}
+
+void BaseDelegate::setQos(bool enabled)
+{
+    m_qos.storeRelease(enabled);
+}
+
+/* GstBaseSink would measure the jitter when show_frame() is called, but
+ * that only posts the frame, so it always looks on time. The render
+ * thread knows when the frame really makes it to the screen, and how
+ * many frames were thrown away for every one shown. That number, averaged
+ * like GstBaseSink averages its rate, is sent as the proportion, so that
+ * upstream elements can skip work on frames that would be replaced. */
+void BaseDelegate::sendQos(GstClockTime runningTime, GstClockTimeDiff jitter)
+{
+    const quint64 received = m_statistics->framesReceived();
+    const quint64 framesPerShown = qMax<quint64>(received - m_qosFramesReceived, 1);
+    m_qosFramesReceived = received;
+
+    // a frame of a stalled stream would weigh too much
+    const double rate = qMin<double>(framesPerShown, 8.0);
+    m_qosProportion = (m_qosProportion * 7.0 + rate) / 8.0;
+
+    if (!qos())
+        return;
+
+    GST_LOG_OBJECT(m_sink, "QoS: running time %" GST_TIME_FORMAT ", jitter %" G_GINT64_FORMAT
+                   ", proportion %f", GST_TIME_ARGS(runningTime), jitter, m_qosProportion);
+
+    GstEvent *event = gst_event_new_qos(jitter > 0 ? GST_QOS_TYPE_UNDERFLOW : GST_QOS_TYPE_OVERFLOW,
+                                        m_qosProportion, jitter, runningTime);
+    gst_pad_push_event(GST_BASE_SINK_PAD(m_sink), event);
+}
+
+//-------------------------------------
+
 int BaseDelegate::brightness() const
 {
-    QReadLocker l(&m_colorsLock);
-    return m_brightness;
+    return m_properties.load().brightness;
 }
 
 void BaseDelegate::setBrightness(int brightness)
 {
-    QWriteLocker l(&m_colorsLock);
-    m_brightness = qBound(-100, brightness, 100);
-    m_colorsDirty = true;
+    m_properties.modify([brightness](DisplayProperties &p) {
+        p.brightness = qBound(-100, brightness, 100);
+        p.colorsVersion++;
+    });
 }
 
 int BaseDelegate::contrast() const
 {
-    QReadLocker l(&m_colorsLock);
-    return m_contrast;
+    return m_properties.load().contrast;
 }
 
 void BaseDelegate::setContrast(int contrast)
 {
-    QWriteLocker l(&m_colorsLock);
-    m_contrast = qBound(-100, contrast, 100);
-    m_colorsDirty = true;
+    m_properties.modify([contrast](DisplayProperties &p) {
+        p.contrast = qBound(-100, contrast, 100);
+        p.colorsVersion++;
+    });
 }
 
 int BaseDelegate::hue() const
 {
-    QReadLocker l(&m_colorsLock);
-    return m_hue;
+    return m_properties.load().hue;
 }
 
 void BaseDelegate::setHue(int hue)
 {
-    QWriteLocker l(&m_colorsLock);
-    m_hue = qBound(-100, hue, 100);
-    m_colorsDirty = true;
+    m_properties.modify([hue](DisplayProperties &p) {
+        p.hue = qBound(-100, hue, 100);
+        p.colorsVersion++;
+    });
 }
 
 int BaseDelegate::saturation() const
 {
-    QReadLocker l(&m_colorsLock);
-    return m_saturation;
+    return m_properties.load().saturation;
 }
 
 void BaseDelegate::setSaturation(int saturation)
 {
-    QWriteLocker l(&m_colorsLock);
-    m_saturation = qBound(-100, saturation, 100);
-    m_colorsDirty = true;
+    m_properties.modify([saturation](DisplayProperties &p) {
+        p.saturation = qBound(-100, saturation, 100);
+        p.colorsVersion++;
+    });
 }
 
 //-------------------------------------
 
 Fraction BaseDelegate::pixelAspectRatio() const
 {
-    QReadLocker l(&m_pixelAspectRatioLock);
-    return m_pixelAspectRatio;
+    return m_properties.load().pixelAspectRatio;
 }
 
 void BaseDelegate::setPixelAspectRatio(const Fraction & f)
 {
-    QWriteLocker l(&m_pixelAspectRatioLock);
-    m_pixelAspectRatio = f;
+    m_properties.modify([f](DisplayProperties &p) {
+        if (p.pixelAspectRatio != f) {
+            p.pixelAspectRatio = f;
+            p.geometryVersion++;
+        }
+    });
 }
 
 //-------------------------------------
 
 bool BaseDelegate::forceAspectRatio() const
 {
-    QReadLocker l(&m_forceAspectRatioLock);
-    return m_forceAspectRatio;
+    return m_properties.load().forceAspectRatio;
 }
 
 void BaseDelegate::setForceAspectRatio(bool force)
 {
-    QWriteLocker l(&m_forceAspectRatioLock);
-    if (m_forceAspectRatio != force) {
-        m_forceAspectRatio = force;
-        m_forceAspectRatioDirty = true;
-    }
+    m_properties.modify([force](DisplayProperties &p) {
+        if (p.forceAspectRatio != force) {
+            p.forceAspectRatio = force;
+            p.geometryVersion++;
+        }
+    });
 }
 
 //-------------------------------------
 
-bool BaseDelegate::event(QEvent *event)
+bool BaseDelegate::usePixelBuffers() const
 {
-    switch((int) event->type()) {
-    case BufferEventType:
-    {
-        BufferEvent *bufEvent = dynamic_cast<BufferEvent*>(event);
-        Q_ASSERT(bufEvent);
+    return m_properties.load().usePixelBuffers;
+}
+
+void BaseDelegate::setUsePixelBuffers(bool use)
+{
+    m_properties.modify([use](DisplayProperties &p) {
+        if (p.usePixelBuffers != use) {
+            p.usePixelBuffers = use;
+            p.pixelBuffersVersion++;
+        }
+    });
+}
 
-        GST_TRACE_OBJECT(m_sink, "Received buffer %" GST_PTR_FORMAT, bufEvent->buffer);
+//-------------------------------------
 
-        if (isActive()) {
-            gst_buffer_replace (&m_buffer, bufEvent->buffer);
-            update();
+bool BaseDelegate::mirror() const
+{
+    return m_properties.load().mirror;
+}
+
+void BaseDelegate::setMirror(bool mirror)
+{
+    m_properties.modify([mirror](DisplayProperties &p) {
+        if (p.mirror != mirror) {
+            p.mirror = mirror;
+            p.geometryVersion++;
         }
+    });
+}
 
-        return true;
-    }
-    case BufferFormatEventType:
-    {
-        BufferFormatEvent *bufFmtEvent = dynamic_cast<BufferFormatEvent*>(event);
-        Q_ASSERT(bufFmtEvent);
+int BaseDelegate::rotation() const
+{
+    return m_properties.load().rotation;
+}
+
+void BaseDelegate::setRotation(int rotation)
+{
+    // the nearest quarter turn, in 0..270
+    rotation = ((rotation % 360 + 360 + 45) / 90 * 90) % 360;
+
+    m_properties.modify([rotation](DisplayProperties &p) {
+        if (p.rotation != rotation) {
+            p.rotation = rotation;
+            p.geometryVersion++;
+        }
+    });
+}
+
+//-------------------------------------
+
+qreal BaseDelegate::zoom() const
+{
+    return m_properties.load().zoom;
+}
+
+void BaseDelegate::setZoom(qreal zoom)
+{
+    m_properties.modify([zoom](DisplayProperties &p) {
+        p.zoom = qMax<qreal>(1, zoom);
+        p.geometryVersion++;
+    });
+}
+
+qreal BaseDelegate::panX() const
+{
+    return m_properties.load().panX;
+}
+
+void BaseDelegate::setPanX(qreal pan)
+{
+    m_properties.modify([pan](DisplayProperties &p) {
+        p.panX = qBound<qreal>(-1, pan, 1);
+        p.geometryVersion++;
+    });
+}
+
+qreal BaseDelegate::panY() const
+{
+    return m_properties.load().panY;
+}
+
+void BaseDelegate::setPanY(qreal pan)
+{
+    m_properties.modify([pan](DisplayProperties &p) {
+        p.panY = qBound<qreal>(-1, pan, 1);
+        p.geometryVersion++;
+    });
+}
+
+//-------------------------------------
+
+VideoEffect::Type BaseDelegate::effect() const
+{
+    return m_properties.load().effect;
+}
+
+void BaseDelegate::setEffect(VideoEffect::Type effect)
+{
+    m_properties.modify([effect](DisplayProperties &p) {
+        if (p.effect != effect) {
+            p.effect = effect;
+            p.effectVersion++;
+        }
+    });
+}
 
-        GST_TRACE_OBJECT (m_sink, "Received buffer format event. New format: %s",
-                          gst_video_format_to_string(bufFmtEvent->format.videoFormat()));
+//-------------------------------------
 
-        m_formatDirty = true;
-        m_bufferFormat = bufFmtEvent->format;
+QByteArray BaseDelegate::colorFilter() const
+{
+    QMutexLocker l(&m_colorFilterMutex);
+    return m_colorLookupTable ? m_colorLookupTable->description() : QByteArray();
+}
 
+bool BaseDelegate::setColorFilter(const QByteArray & description)
+{
+    // the same filter is set again e.g. whenever the source filter is
+    // rebuilt; baking it takes a while, so keep the table already there
+    if (colorFilter().trimmed() == description.trimmed())
         return true;
+
+    ColorLookupTable::Ptr table;
+    if (!description.trimmed().isEmpty()) {
+        GError *error = NULL;
+        table = ColorLookupTable::bake(description, ColorLookupTable::Default_Size, &error);
+        if (!table) {
+            GST_WARNING_OBJECT(m_sink, "Failed to bake color filter \"%s\": %s",
+                               description.constData(), error ? error->message : "unknown error");
+            g_clear_error(&error);
+        } else {
+            GST_DEBUG_OBJECT(m_sink, "Baked color filter \"%s\" into a lookup table",
+                             description.constData());
+        }
     }
+
+    m_colorFilterMutex.lock();
+    m_colorLookupTable = table;
+    m_colorFilterMutex.unlock();
+
+    m_properties.modify([](DisplayProperties &p) {
+        p.colorFilterVersion++;
+    });
+    return table || description.trimmed().isEmpty();
+}
+
+ColorLookupTable::Ptr BaseDelegate::colorLookupTable() const
+{
+    QMutexLocker l(&m_colorFilterMutex);
+    return m_colorLookupTable;
+}
+
+//-------------------------------------
+
+bool BaseDelegate::event(QEvent *event)
+{
+    switch((int) event->type()) {
     case DeactivateEventType:
     {
         GST_LOG_OBJECT(m_sink, "Received deactivate event");
 
+        delete m_pendingFrame.fetchAndStoreOrdered(NULL);
+        dropPacedFrames();
         gst_buffer_replace (&m_buffer, NULL);
         update();
 
         return true;
     }
+    case UpdateEventType:
+    {
+        // cleared first, so that a frame pushed from now on asks again
+        m_updatePending.storeRelease(0);
+        update();
+
+        return true;
+    }
     default:
         return QObject::event(event);
     }
@@ -23,49 +23,67 @@
 #include "../gstqtvideosinkplugin.h" //for debug category
 #include "../utils/bufferformat.h"
 #include "../utils/utils.h"
+#include "../utils/seqlock.h"
+#include "../utils/renderstatistics.h"
+#include "../utils/colorlookuptable.h"
+#include "../painters/videoeffect.h"
 
 #include <QObject>
 #include <QEvent>
-#include <QReadWriteLock>
+#include <QAtomicPointer>
+#include <QMutex>
+#include <QList>
+
+// everything that affects how frames are displayed; written by the
+// property setters from any thread, read by the render thread
+struct DisplayProperties
+{
+    DisplayProperties()
+        : brightness(0), contrast(0), hue(0), saturation(0),
+          pixelAspectRatio(1, 1), forceAspectRatio(false), usePixelBuffers(false),
+          mirror(false), rotation(0), zoom(1), panX(0), panY(0),
+          effect(VideoEffect::None),
+          colorsVersion(0), geometryVersion(0), pixelBuffersVersion(0), effectVersion(0),
+          colorFilterVersion(0)
+    {}
+
+    int brightness;
+    int contrast;
+    int hue;
+    int saturation;
+    Fraction pixelAspectRatio;
+    bool forceAspectRatio;
+    bool usePixelBuffers;
+
+    // how the frames are oriented and which part of them is shown
+    bool mirror;
+    int rotation; // clockwise, in degrees; a multiple of 90
+    qreal zoom;
+    qreal panX;
+    qreal panY;
+
+    VideoEffect::Type effect;
+
+    // bumped by the setters; the render thread compares them with the
+    // versions it has applied last
+    quint32 colorsVersion;
+    quint32 geometryVersion;
+    quint32 pixelBuffersVersion;
+    quint32 effectVersion;
+    quint32 colorFilterVersion;
+};
 
 class BaseDelegate : public QObject
 {
     Q_OBJECT
 public:
     enum EventType {
-        BufferEventType = QEvent::User,
-        BufferFormatEventType,
-        DeactivateEventType
+        DeactivateEventType = QEvent::User,
+        UpdateEventType
     };
 
     //-------------------------------------
 
-    class BufferEvent : public QEvent
-    {
-    public:
-        inline BufferEvent(GstBuffer *buf)
-            : QEvent(static_cast<QEvent::Type>(BufferEventType)),
-              buffer(gst_buffer_ref(buf))
-        {}
-
-        virtual ~BufferEvent() {
-            gst_buffer_unref(buffer);
-        }
-
-        GstBuffer *buffer;
-    };
-
-    class BufferFormatEvent : public QEvent
-    {
-    public:
-        inline BufferFormatEvent(const BufferFormat &format)
-            : QEvent(static_cast<QEvent::Type>(BufferFormatEventType)),
-            format(format)
-        {}
-
-        BufferFormat format;
-    };
-
     class DeactivateEvent : public QEvent
     {
     public:
@@ -83,6 +101,27 @@ public:
     bool isActive() const;
     void setActive(bool playing);
 
+    // frame delivery, called from the streaming thread; runningTime is
+    // the running time of the buffer, or GST_CLOCK_TIME_NONE
+    void setStreamFormat(const BufferFormat & format);
+    void pushBuffer(GstBuffer *buffer, GstClockTime runningTime = GST_CLOCK_TIME_NONE);
+
+    // qos property; the sink's own QoS is turned off in favour of this
+    bool qos() const;
+    void setQos(bool enabled);
+
+    // visible property; hidden sinks keep the latest frame but do not
+    // ask for it to be drawn
+    bool isVisible() const;
+    void setVisible(bool visible);
+
+    // pacing-latency property, in ns; 0 shows every frame as it comes
+    GstClockTime pacingLatency() const;
+    void setPacingLatency(GstClockTime latency);
+
+    // the read-only statistics properties
+    const RenderStatistics::Ptr & statistics() const { return m_statistics; }
+
     // GstColorBalance interface
 
     int brightness() const;
@@ -105,6 +144,36 @@ public:
     bool forceAspectRatio() const;
     void setForceAspectRatio(bool force);
 
+    // use-pbo property
+    bool usePixelBuffers() const;
+    void setUsePixelBuffers(bool use);
+
+    // mirror and rotation properties
+    bool mirror() const;
+    void setMirror(bool mirror);
+
+    int rotation() const;
+    void setRotation(int rotation);
+
+    // zoom, pan-x and pan-y properties
+    qreal zoom() const;
+    void setZoom(qreal zoom);
+
+    qreal panX() const;
+    void setPanX(qreal pan);
+
+    qreal panY() const;
+    void setPanY(qreal pan);
+
+    // effect property
+    VideoEffect::Type effect() const;
+    void setEffect(VideoEffect::Type effect);
+
+    // color-filter property; the elements are baked into a lookup table
+    // right away. If that fails, there is no table and false is returned
+    QByteArray colorFilter() const;
+    bool setColorFilter(const QByteArray & description);
+
 protected:
     // internal event handling
     virtual bool event(QEvent *event);
@@ -112,36 +181,86 @@ protected:
     // tells the surface to repaint itself
     virtual void update();
 
-protected:
-    // colorbalance interface properties
-    mutable QReadWriteLock m_colorsLock;
-    bool m_colorsDirty;
-    int m_brightness;
-    int m_contrast;
-    int m_hue;
-    int m_saturation;
+    // picks up the frame to show next, if there is a new one; to be called
+    // from the render thread while it syncs with the items. With pacing,
+    // that is the last frame due by the time the picture being prepared
+    // reaches the screen, refreshInterval from now
+    bool takeFrame(GstClockTime refreshInterval);
 
-    // pixel-aspect-ratio property
-    mutable QReadWriteLock m_pixelAspectRatioLock;
-    Fraction m_pixelAspectRatio;
+    // how late a frame with the given running time is shown, by the
+    // pipeline clock, in ns; negative if it is early. False if the clock
+    // or the time is unknown
+    bool jitter(GstClockTime runningTime, GstClockTimeDiff *jitter) const;
 
-    // force-aspect-ratio property
-    mutable QReadWriteLock m_forceAspectRatioLock;
-    bool m_forceAspectRatioDirty;
-    bool m_forceAspectRatio;
+    // tells upstream how late the frame shown last was
+    void sendQos(GstClockTime runningTime, GstClockTimeDiff jitter);
 
-    // format caching
-    bool m_formatDirty;
+    // asks the GUI thread for a sync with the items, unless that is pending
+    void requestUpdate();
+
+    // the table for the color-filter property, NULL if there is none
+    ColorLookupTable::Ptr colorLookupTable() const;
+
+protected:
+    // all the properties above, read without locking by updateNode()
+    SeqLock<DisplayProperties> m_properties;
+
+    // too large for the above; colorFilterVersion tells when it changes
+    mutable QMutex m_colorFilterMutex;
+    ColorLookupTable::Ptr m_colorLookupTable;
+
+    // the format of m_buffer
     BufferFormat m_bufferFormat;
-    PaintAreas m_areas;
 
     // whether the sink is active (PAUSED or PLAYING)
-    mutable QReadWriteLock m_isActiveLock;
-    bool m_isActive;
+    QAtomicInt m_isActive;
 
     // the buffer to be drawn next
     GstBuffer *m_buffer;
 
+    // a frame on its way from the streaming thread to the render thread
+    struct Frame
+    {
+        inline Frame(GstBuffer *buf, const BufferFormat & format, GstClockTime runningTime)
+            : buffer(gst_buffer_ref(buf)), format(format), runningTime(runningTime) {}
+        inline ~Frame() { gst_buffer_unref(buffer); }
+
+        GstBuffer *buffer;
+        BufferFormat format;
+        GstClockTime runningTime;
+    };
+
+    // single slot mailbox, always holding the most recent frame
+    QAtomicPointer<Frame> m_pendingFrame;
+    QAtomicInt m_updatePending;
+
+    // with pacing, the frames wait here until they are due instead
+    static const int Max_Paced_Frames = 16;
+    Frame *takePacedFrame(GstClockTime refreshInterval);
+    void dropPacedFrames();
+
+    QMutex m_pacedFramesMutex;
+    QList<Frame*> m_pacedFrames;
+    QAtomicInteger<quint64> m_pacingLatency;
+
+    QAtomicInt m_visible;
+
+    // counters and timings, shared with the materials
+    RenderStatistics::Ptr m_statistics;
+
+    // QoS as measured by the render thread, which only touches the rest
+    QAtomicInt m_qos;
+    double m_qosProportion;
+    quint64 m_qosFramesReceived;
+
+    // the caps of the buffers pushed next; streaming thread only
+    BufferFormat m_streamFormat;
+
+    // the same for frames whose GstVideoMeta makes them larger than the
+    // caps say, kept so that the materials are not recreated every frame
+    BufferFormat m_paddedFormat;
+    BufferFormat frameFormat(GstBuffer *buffer);
+
     // the video sink element
     GstElement * const m_sink;
 };
@@ -17,87 +17,306 @@
 
 #include "qtquick2videosinkdelegate.h"
 #include "../painters/videonode.h"
+#include "../painters/softwarevideonode.h"
+
+#include <gst/base/gstbasesink.h>
+#include <QOpenGLContext>
+#include <QQuickWindow>
+#include <QScreen>
+
+/* Maps points of the picture as displayed, normalized to 0..1, to texture
+ * coordinates. The picture is the visible part of the frame, rotated
+ * clockwise, then mirrored, then zoomed into. */
+static QTransform textureTransform(const QRect &visible, const BufferFormat &format,
+                                   const DisplayProperties &properties)
+{
+    //the zoomed in window, panned within the whole picture
+    const qreal window = 1 / properties.zoom;
+    const QTransform zoom(window, 0, 0, window,
+                          (1 - window) * (properties.panX + 1) / 2,
+                          (1 - window) * (properties.panY + 1) / 2);
+
+    const QTransform mirror = properties.mirror ?
+            QTransform(-1, 0, 0, 1, 1, 0) : QTransform();
+
+    QTransform rotation;
+    switch (properties.rotation) {
+    case 90:
+        rotation = QTransform(0, -1, 1, 0, 0, 1);
+        break;
+    case 180:
+        rotation = QTransform(-1, 0, 0, -1, 1, 1);
+        break;
+    case 270:
+        rotation = QTransform(0, 1, -1, 0, 1, 0);
+        break;
+    default:
+        break;
+    }
+
+    return zoom * mirror * rotation * format.cropTransform(visible);
+}
+
+//the window being drawn, whichever scene graph draws it
+static QWindow *renderWindow(QQuickWindow *window)
+{
+    if (window)
+        return window;
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QSurface *surface = context ? context->surface() : NULL;
+    if (surface && surface->surfaceClass() == QSurface::Window)
+        return static_cast<QWindow*>(surface);
+
+    return NULL;
+}
+
+static qreal devicePixelRatio(QWindow *window)
+{
+    return window ? window->devicePixelRatio() : 1;
+}
+
+//how long a picture being prepared now takes to reach the screen
+static GstClockTime refreshInterval(QWindow *window)
+{
+    QScreen *screen = window ? window->screen() : NULL;
+    if (screen && screen->refreshRate() > 0)
+        return GstClockTime(GST_SECOND / screen->refreshRate());
+
+    return GST_SECOND / 60;
+}
+
+//where the cropped frame goes within targetArea
+static PaintAreas paintAreas(const QRectF & targetArea, const QRect & crop,
+                             const BufferFormat & format, const DisplayProperties & properties)
+{
+    Qt::AspectRatioMode aspectRatioMode = properties.forceAspectRatio ?
+            Qt::KeepAspectRatio : Qt::IgnoreAspectRatio;
+
+    //a quarter turn swaps the sides of the picture and of its pixels
+    const bool transposed = (properties.rotation % 180 != 0);
+    const Fraction par = format.pixelAspectRatio();
+
+    PaintAreas areas;
+    areas.calculate(targetArea,
+            transposed ? crop.size().transposed() : crop.size(),
+            transposed ? Fraction(par.denominator, par.numerator) : par,
+            properties.pixelAspectRatio, aspectRatioMode);
+    return areas;
+}
+
+//the limit negotiated for items of the given size: a bit larger, so that
+//small resizes stay within it, and rounded to what scalers like
+static QSize frameSizeLimit(const QSize &displaySize)
+{
+    return QSize((displaySize.width() * 5 / 4 + 15) & ~15,
+                 (displaySize.height() * 5 / 4 + 15) & ~15);
+}
 
 QtQuick2VideoSinkDelegate::QtQuick2VideoSinkDelegate(GstElement *sink, QObject *parent)
     : BaseDelegate(sink, parent)
+    , m_materials(new SharedVideoMaterials(m_statistics))
+    , m_adaptiveSize(0)
+{
+}
+
+bool QtQuick2VideoSinkDelegate::adaptiveSize() const
+{
+    return m_adaptiveSize.loadAcquire();
+}
+
+void QtQuick2VideoSinkDelegate::setAdaptiveSize(bool adaptive)
+{
+    m_adaptiveSize.storeRelease(adaptive);
+
+    //the next sync picks a limit again
+    if (!adaptive)
+        setMaximumFrameSize(QSize());
+}
+
+QSize QtQuick2VideoSinkDelegate::maximumFrameSize() const
+{
+    return m_maximumFrameSize.load();
+}
+
+void QtQuick2VideoSinkDelegate::setMaximumFrameSize(const QSize & size)
+{
+    const QSize old = m_maximumFrameSize.load();
+    if (old == size)
+        return;
+
+    m_maximumFrameSize.store(size);
+    GST_DEBUG_OBJECT(m_sink, "Asking upstream for frames of at most " QSIZE_FORMAT,
+                     QSIZE_FORMAT_ARGS(size));
+
+    //upstream queries our caps again before its next buffer
+    gst_pad_push_event(GST_BASE_SINK_PAD(m_sink), gst_event_new_reconfigure());
+}
+
+/* All the items of a surface are updated for every new frame, so the
+ * largest of the sizes seen between two frames is the one to negotiate.
+ * The limit grows as soon as an item outgrows it, but only shrinks when
+ * all of them got a lot smaller, so that resizing a window does not
+ * renegotiate over and over. */
+void QtQuick2VideoSinkDelegate::updateDisplaySize(const QSize & size, bool newFrame)
 {
+    if (!adaptiveSize() || size.isEmpty())
+        return;
+
+    const QSize limit = m_maximumFrameSize.load();
+
+    if (newFrame) {
+        if (m_displaySize.width() * 2 < limit.width()
+            && m_displaySize.height() * 2 < limit.height()) {
+            setMaximumFrameSize(frameSizeLimit(m_displaySize));
+        }
+        m_displaySize = QSize();
+    }
+
+    m_displaySize = m_displaySize.expandedTo(size);
+    if (limit.isEmpty() || m_displaySize.width() > limit.width()
+        || m_displaySize.height() > limit.height()) {
+        setMaximumFrameSize(frameSizeLimit(m_displaySize));
+    }
 }
 
-QSGNode* QtQuick2VideoSinkDelegate::updateNode(QSGNode *node, const QRectF & targetArea)
+QSGNode* QtQuick2VideoSinkDelegate::updateNode(QSGNode *node, const QRectF & targetArea,
+                                               QQuickWindow *window)
 {
     GST_TRACE_OBJECT(m_sink, "updateNode called");
     bool sgnodeFormatChanged = false;
+    QWindow *target = renderWindow(window);
+
+    //every item of the surface calls this; only the first one takes the frame
+    const bool newFrame = takeFrame(refreshInterval(target));
+    updateDisplaySize((targetArea.size() * devicePixelRatio(target)).toSize(), newFrame);
+
+    if (!QOpenGLContext::currentContext())
+        return updateSoftwareNode(node, targetArea, window);
 
     VideoNode *vnode = dynamic_cast<VideoNode*>(node);
     if (!vnode) {
         GST_INFO_OBJECT(m_sink, "creating new VideoNode");
         vnode = new VideoNode;
-        m_formatDirty = true;
     }
+    VideoNode::State &state = vnode->state();
 
     if (!m_buffer) {
         if (vnode->materialType() != VideoNode::MaterialTypeSolidBlack) {
             vnode->setMaterialTypeSolidBlack();
             sgnodeFormatChanged = true;
         }
-        if (sgnodeFormatChanged || targetArea != m_areas.targetArea || !vnode->geometry()) {
-            m_areas.targetArea = targetArea;
-            vnode->updateGeometry(m_areas);
+        if (sgnodeFormatChanged || targetArea != state.areas.targetArea || !vnode->geometry()) {
+            state.areas.targetArea = targetArea;
+            vnode->updateGeometry(state.areas);
         }
     } else {
         //change format before geometry, so that we change QSGGeometry as well
-        if (m_formatDirty) {
-            vnode->changeFormat(m_bufferFormat);
+        if (vnode->materialType() != VideoNode::MaterialTypeVideo
+            || vnode->format() != m_bufferFormat) {
+            vnode->changeFormat(m_bufferFormat, m_materials);
             sgnodeFormatChanged = true;
         }
 
+        //upstream may ask us to show only a part of the frame
+        const QSize frameSize = m_bufferFormat.frameSize();
+        const QRect crop = m_bufferFormat.visibleRect(m_buffer);
+        const bool cropChanged = (crop != state.cropRect);
+        state.cropRect = crop;
+
+        //one consistent copy of the properties, whatever other threads do
+        const DisplayProperties properties = m_properties.load();
+
         //recalculate the video area if needed
-        QReadLocker forceAspectRatioLocker(&m_forceAspectRatioLock);
-        if (sgnodeFormatChanged || targetArea != m_areas.targetArea || m_forceAspectRatioDirty) {
-            m_forceAspectRatioDirty = false;
-
-            QReadLocker pixelAspectRatioLocker(&m_pixelAspectRatioLock);
-            Qt::AspectRatioMode aspectRatioMode = m_forceAspectRatio ?
-                    Qt::KeepAspectRatio : Qt::IgnoreAspectRatio;
-            m_areas.calculate(targetArea, m_bufferFormat.frameSize(),
-                    m_bufferFormat.pixelAspectRatio(), m_pixelAspectRatio,
-                    aspectRatioMode);
-            pixelAspectRatioLocker.unlock();
+        if (sgnodeFormatChanged || targetArea != state.areas.targetArea || cropChanged
+            || properties.geometryVersion != state.geometryVersion) {
+            state.geometryVersion = properties.geometryVersion;
+
+            state.areas = paintAreas(targetArea, crop, m_bufferFormat, properties);
 
             GST_LOG_OBJECT(m_sink,
                 "Recalculated paint areas: "
                 "Frame size: " QSIZE_FORMAT ", "
+                "crop: " QRECTF_FORMAT ", "
                 "target area: " QRECTF_FORMAT ", "
                 "video area: " QRECTF_FORMAT ", "
                 "black1: " QRECTF_FORMAT ", "
                 "black2: " QRECTF_FORMAT,
-                QSIZE_FORMAT_ARGS(m_bufferFormat.frameSize()),
-                QRECTF_FORMAT_ARGS(m_areas.targetArea),
-                QRECTF_FORMAT_ARGS(m_areas.videoArea),
-                QRECTF_FORMAT_ARGS(m_areas.blackArea1),
-                QRECTF_FORMAT_ARGS(m_areas.blackArea2)
+                QSIZE_FORMAT_ARGS(frameSize),
+                QRECTF_FORMAT_ARGS(QRectF(crop)),
+                QRECTF_FORMAT_ARGS(state.areas.targetArea),
+                QRECTF_FORMAT_ARGS(state.areas.videoArea),
+                QRECTF_FORMAT_ARGS(state.areas.blackArea1),
+                QRECTF_FORMAT_ARGS(state.areas.blackArea2)
             );
 
-            vnode->updateGeometry(m_areas);
+            //sourceRect is relative to the displayed picture; the textures
+            //always hold the whole frame as it came
+            vnode->updateGeometry(state.areas, textureTransform(crop, m_bufferFormat, properties));
         }
-        forceAspectRatioLocker.unlock();
 
-        if (m_formatDirty) {
-            m_formatDirty = false;
+        //a new material starts with the default settings
+        if (sgnodeFormatChanged || properties.pixelBuffersVersion != state.pixelBuffersVersion) {
+            vnode->setUsePixelBuffers(properties.usePixelBuffers);
+            state.pixelBuffersVersion = properties.pixelBuffersVersion;
+        }
 
-            //make sure to update the colors after changing material
-            m_colorsDirty = true;
+        if (sgnodeFormatChanged || properties.colorsVersion != state.colorsVersion) {
+            vnode->updateColors(properties.brightness, properties.contrast,
+                                properties.hue, properties.saturation);
+            state.colorsVersion = properties.colorsVersion;
         }
 
-        QReadLocker colorsLocker(&m_colorsLock);
-        if (m_colorsDirty) {
-            vnode->updateColors(m_brightness, m_contrast, m_hue, m_saturation);
-            m_colorsDirty = false;
+        if (sgnodeFormatChanged || properties.effectVersion != state.effectVersion) {
+            vnode->setEffect(properties.effect);
+            state.effectVersion = properties.effectVersion;
+        }
+
+        if (sgnodeFormatChanged || properties.colorFilterVersion != state.colorFilterVersion) {
+            vnode->setColorLookupTable(colorLookupTable());
+            state.colorFilterVersion = properties.colorFilterVersion;
         }
-        colorsLocker.unlock();
 
         vnode->setCurrentFrame(m_buffer);
     }
 
     return vnode;
 }
+
+/* The software scene graph has no shaders, so the frame is converted on the
+ * CPU instead. The effects and the color filter are left out there. */
+QSGNode* QtQuick2VideoSinkDelegate::updateSoftwareNode(QSGNode *node, const QRectF & targetArea,
+                                                       QQuickWindow *window)
+{
+    //its nodes can only be made by the window
+    if (!window) {
+        GST_WARNING_OBJECT(m_sink, "Cannot draw without OpenGL unless given the window");
+        return node;
+    }
+
+    SoftwareVideoNode *snode = dynamic_cast<SoftwareVideoNode*>(node);
+    if (!snode) {
+        GST_INFO_OBJECT(m_sink, "creating new SoftwareVideoNode");
+        snode = new SoftwareVideoNode(window);
+    }
+
+    if (!m_buffer || !SoftwareConverter::supportsFormat(m_bufferFormat.videoFormat())) {
+        snode->setBlack(targetArea);
+        return snode;
+    }
+
+    const DisplayProperties properties = m_properties.load();
+    if (properties.colorsVersion != snode->colorsVersion) {
+        snode->updateColors(properties.brightness, properties.contrast,
+                            properties.hue, properties.saturation);
+        snode->colorsVersion = properties.colorsVersion;
+    }
+
+    const QRect crop = m_bufferFormat.visibleRect(m_buffer);
+    snode->setCurrentFrame(m_buffer, m_bufferFormat,
+                           paintAreas(targetArea, crop, m_bufferFormat, properties),
+                           textureTransform(crop, m_bufferFormat, properties),
+                           devicePixelRatio(window), m_statistics);
+
+    return snode;
+}
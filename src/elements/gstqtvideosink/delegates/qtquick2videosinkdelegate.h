@@ -18,15 +18,41 @@
 #define QTQUICK2VIDEOSINKDELEGATE_H
 
 #include "basedelegate.h"
+#include "../painters/sharedvideomaterials.h"
 #include <QtQuick/QSGNode>
 
+class QQuickWindow;
+
 class QtQuick2VideoSinkDelegate : public BaseDelegate
 {
     Q_OBJECT
 public:
     explicit QtQuick2VideoSinkDelegate(GstElement * sink, QObject * parent = 0);
 
-    QSGNode *updateNode(QSGNode *node, const QRectF & targetArea);
+    // window is the one the item is in; without it, only OpenGL works
+    QSGNode *updateNode(QSGNode *node, const QRectF & targetArea, QQuickWindow *window = NULL);
+
+    // adaptive-size property
+    bool adaptiveSize() const;
+    void setAdaptiveSize(bool adaptive);
+
+    // the largest frames worth negotiating; empty if there is no limit
+    QSize maximumFrameSize() const;
+
+private:
+    QSGNode *updateSoftwareNode(QSGNode *node, const QRectF & targetArea, QQuickWindow *window);
+
+    void updateDisplaySize(const QSize & size, bool newFrame);
+    void setMaximumFrameSize(const QSize & size);
+
+    // the textures every node of this sink draws from, per window
+    SharedVideoMaterials::Ptr m_materials;
+
+    QAtomicInt m_adaptiveSize;
+    SeqLock<QSize> m_maximumFrameSize;
+    // the largest item that showed the current frame, in device pixels;
+    // render thread only
+    QSize m_displaySize;
 };
 
 #endif // QTQUICK2VIDEOSINKDELEGATE_H
@@ -0,0 +1,341 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+/* Turns the MJPEG of USB cameras into raw video. jpegdec decodes one
+ * frame at a time, which at 1080p30 is more than a core can do on many
+ * machines; this decodes as many frames at once as there are cores and
+ * pushes them out in order. */
+
+#include "gstqtjpegdec.h"
+#include "gstqtvideosinkplugin.h"
+#include "utils/paralleljpegdecoder.h"
+#include "utils/decodetimemeta.h"
+
+#include <gst/video/video.h>
+
+// QImage::Format_RGB32, as bytes
+#if G_BYTE_ORDER == G_LITTLE_ENDIAN
+# define OUTPUT_FORMAT "BGRx"
+#else
+# define OUTPUT_FORMAT "xRGB"
+#endif
+
+#define GST_QT_JPEG_DEC_GET_PRIVATE(obj) \
+    (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_QT_JPEG_DEC, GstQtJpegDecPrivate))
+
+struct _GstQtJpegDecPrivate
+{
+    GstPad *sinkpad;
+    GstPad *srcpad;
+
+    // only while PAUSED or PLAYING
+    ParallelJpegDecoder *decoder;
+    guint max_threads;
+
+    // the size every frame is expected to decode to
+    GstVideoInfo info;
+    gboolean negotiated;
+};
+
+#define parent_class gst_qt_jpeg_dec_parent_class
+G_DEFINE_TYPE (GstQtJpegDec, gst_qt_jpeg_dec, GST_TYPE_ELEMENT);
+
+enum {
+    PROP_0,
+    PROP_MAX_THREADS,
+};
+
+static GstStaticPadTemplate sink_pad_template =
+    GST_STATIC_PAD_TEMPLATE("sink", GST_PAD_SINK, GST_PAD_ALWAYS,
+        GST_STATIC_CAPS ("image/jpeg")
+    );
+
+static GstStaticPadTemplate src_pad_template =
+    GST_STATIC_PAD_TEMPLATE("src", GST_PAD_SRC, GST_PAD_ALWAYS,
+        GST_STATIC_CAPS (GST_VIDEO_CAPS_MAKE (OUTPUT_FORMAT))
+    );
+
+static void
+gst_qt_jpeg_dec_destroy_image(gpointer image)
+{
+    delete static_cast<QImage*>(image);
+}
+
+static GstFlowReturn
+gst_qt_jpeg_dec_push_frame(GstQtJpegDec *self, const ParallelJpegDecoder::Frame & frame)
+{
+    const GstVideoInfo & info = self->priv->info;
+
+    if (frame.image.width() != GST_VIDEO_INFO_WIDTH(&info)
+            || frame.image.height() != GST_VIDEO_INFO_HEIGHT(&info)) {
+        GST_WARNING_OBJECT(self, "Dropping %" GST_PTR_FORMAT ", which did not decode to %dx%d",
+                           frame.buffer, GST_VIDEO_INFO_WIDTH(&info), GST_VIDEO_INFO_HEIGHT(&info));
+        gst_buffer_unref(frame.buffer);
+        return GST_FLOW_OK;
+    }
+
+    // the rows of an RGB32 QImage are as long as GStreamer expects them
+    QImage *image = new QImage(frame.image);
+    const gsize size = image->bytesPerLine() * image->height();
+    GstBuffer *buffer = gst_buffer_new_wrapped_full(GST_MEMORY_FLAG_READONLY,
+            const_cast<uchar*>(image->constBits()), size, 0, size,
+            image, gst_qt_jpeg_dec_destroy_image);
+
+    gst_buffer_copy_into(buffer, frame.buffer,
+            static_cast<GstBufferCopyFlags>(GST_BUFFER_COPY_FLAGS | GST_BUFFER_COPY_TIMESTAMPS), 0, -1);
+    gst_buffer_add_qt_decode_time_meta(buffer, frame.decodeTime);
+    gst_buffer_unref(frame.buffer);
+
+    return gst_pad_push(self->priv->srcpad, buffer);
+}
+
+/* Pushes the frames that are decoded, oldest first, waiting for them
+ * until at most keep are left. After an error, the rest is dropped. */
+static GstFlowReturn
+gst_qt_jpeg_dec_push_frames(GstQtJpegDec *self, int keep)
+{
+    ParallelJpegDecoder *decoder = self->priv->decoder;
+    GstFlowReturn ret = GST_FLOW_OK;
+    if (!decoder)
+        return GST_FLOW_FLUSHING;
+
+    ParallelJpegDecoder::Frame frame;
+    while (decoder->take(&frame, decoder->pending() > keep)) {
+        if (ret == GST_FLOW_OK)
+            ret = gst_qt_jpeg_dec_push_frame(self, frame);
+        else
+            gst_buffer_unref(frame.buffer);
+    }
+    return ret;
+}
+
+static GstFlowReturn
+gst_qt_jpeg_dec_chain(GstPad *pad, GstObject *parent, GstBuffer *buffer)
+{
+    Q_UNUSED(pad);
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (parent);
+
+    if (!self->priv->negotiated) {
+        gst_buffer_unref(buffer);
+        return GST_FLOW_NOT_NEGOTIATED;
+    }
+
+    ParallelJpegDecoder *decoder = self->priv->decoder;
+    decoder->push(buffer);
+    gst_buffer_unref(buffer);
+
+    // one frame waiting for a thread keeps them all busy
+    return gst_qt_jpeg_dec_push_frames(self, decoder->threads());
+}
+
+static gboolean
+gst_qt_jpeg_dec_set_caps(GstQtJpegDec *self, GstCaps *caps)
+{
+    GST_LOG_OBJECT(self, "new caps %" GST_PTR_FORMAT, caps);
+
+    const GstStructure *structure = gst_caps_get_structure(caps, 0);
+    int width, height;
+    if (!gst_structure_get_int(structure, "width", &width)
+            || !gst_structure_get_int(structure, "height", &height)) {
+        GST_WARNING_OBJECT(self, "JPEG caps without a size: %" GST_PTR_FORMAT, caps);
+        return FALSE;
+    }
+
+    GstVideoInfo *info = &self->priv->info;
+    gst_video_info_set_format(info, gst_video_format_from_string(OUTPUT_FORMAT), width, height);
+    gst_structure_get_fraction(structure, "framerate", &info->fps_n, &info->fps_d);
+    gst_structure_get_fraction(structure, "pixel-aspect-ratio", &info->par_n, &info->par_d);
+
+    GstCaps *output = gst_video_info_to_caps(info);
+    self->priv->negotiated = gst_pad_set_caps(self->priv->srcpad, output);
+    gst_caps_unref(output);
+    return self->priv->negotiated;
+}
+
+static gboolean
+gst_qt_jpeg_dec_sink_event(GstPad *pad, GstObject *parent, GstEvent *event)
+{
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (parent);
+
+    switch (GST_EVENT_TYPE(event)) {
+    case GST_EVENT_CAPS:
+      {
+        // frames of the old size go first
+        gst_qt_jpeg_dec_push_frames(self, 0);
+
+        GstCaps *caps;
+        gst_event_parse_caps(event, &caps);
+        const gboolean ret = gst_qt_jpeg_dec_set_caps(self, caps);
+        gst_event_unref(event);
+        return ret;
+      }
+    case GST_EVENT_FLUSH_STOP:
+        if (self->priv->decoder)
+            self->priv->decoder->flush();
+        break;
+    default:
+        // the rest of the stream must not overtake the frames
+        if (GST_EVENT_IS_SERIALIZED(event))
+            gst_qt_jpeg_dec_push_frames(self, 0);
+        break;
+    }
+
+    return gst_pad_event_default(pad, parent, event);
+}
+
+static gboolean
+gst_qt_jpeg_dec_src_query(GstPad *pad, GstObject *parent, GstQuery *query)
+{
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (parent);
+
+    if (GST_QUERY_TYPE(query) != GST_QUERY_LATENCY)
+        return gst_pad_query_default(pad, parent, query);
+
+    if (!gst_pad_peer_query(self->priv->sinkpad, query))
+        return FALSE;
+
+    // a frame may wait for as many before it as there are threads
+    const GstVideoInfo & info = self->priv->info;
+    if (self->priv->decoder && info.fps_n > 0) {
+        const GstClockTime delay = gst_util_uint64_scale_int(
+                self->priv->decoder->threads() * GST_SECOND, info.fps_d, info.fps_n);
+
+        gboolean live;
+        GstClockTime min, max;
+        gst_query_parse_latency(query, &live, &min, &max);
+        min += delay;
+        if (GST_CLOCK_TIME_IS_VALID(max))
+            max += delay;
+        gst_query_set_latency(query, live, min, max);
+    }
+    return TRUE;
+}
+
+static GstStateChangeReturn
+gst_qt_jpeg_dec_change_state(GstElement *element, GstStateChange transition)
+{
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (element);
+
+    if (transition == GST_STATE_CHANGE_READY_TO_PAUSED) {
+        GST_OBJECT_LOCK(self);
+        const guint threads = self->priv->max_threads;
+        GST_OBJECT_UNLOCK(self);
+
+        self->priv->decoder = new ParallelJpegDecoder(threads);
+        GST_DEBUG_OBJECT(self, "Decoding on %d threads", self->priv->decoder->threads());
+    }
+
+    const GstStateChangeReturn ret = GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
+
+    // the streaming thread has stopped by now
+    if (transition == GST_STATE_CHANGE_PAUSED_TO_READY) {
+        delete self->priv->decoder;
+        self->priv->decoder = NULL;
+        self->priv->negotiated = FALSE;
+    }
+    return ret;
+}
+
+static void
+gst_qt_jpeg_dec_set_property(GObject *object, guint property_id,
+                             const GValue *value, GParamSpec *pspec)
+{
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (object);
+
+    switch (property_id) {
+    case PROP_MAX_THREADS:
+        GST_OBJECT_LOCK(self);
+        self->priv->max_threads = g_value_get_uint(value);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+gst_qt_jpeg_dec_get_property(GObject *object, guint property_id,
+                             GValue *value, GParamSpec *pspec)
+{
+    GstQtJpegDec *self = GST_QT_JPEG_DEC (object);
+
+    switch (property_id) {
+    case PROP_MAX_THREADS:
+        GST_OBJECT_LOCK(self);
+        g_value_set_uint(value, self->priv->max_threads);
+        GST_OBJECT_UNLOCK(self);
+        break;
+    default:
+        G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
+        break;
+    }
+}
+
+static void
+gst_qt_jpeg_dec_init(GstQtJpegDec *self)
+{
+    self->priv = GST_QT_JPEG_DEC_GET_PRIVATE (self);
+    self->priv->decoder = NULL;
+    self->priv->max_threads = 0;
+    self->priv->negotiated = FALSE;
+    gst_video_info_init(&self->priv->info);
+
+    self->priv->sinkpad = gst_pad_new_from_static_template(&sink_pad_template, "sink");
+    gst_pad_set_chain_function(self->priv->sinkpad, gst_qt_jpeg_dec_chain);
+    gst_pad_set_event_function(self->priv->sinkpad, gst_qt_jpeg_dec_sink_event);
+    gst_element_add_pad(GST_ELEMENT(self), self->priv->sinkpad);
+
+    self->priv->srcpad = gst_pad_new_from_static_template(&src_pad_template, "src");
+    gst_pad_set_query_function(self->priv->srcpad, gst_qt_jpeg_dec_src_query);
+    gst_pad_use_fixed_caps(self->priv->srcpad);
+    gst_element_add_pad(GST_ELEMENT(self), self->priv->srcpad);
+}
+
+static void
+gst_qt_jpeg_dec_class_init(GstQtJpegDecClass *klass)
+{
+    GObjectClass *gobject_class = G_OBJECT_CLASS (klass);
+    gobject_class->set_property = gst_qt_jpeg_dec_set_property;
+    gobject_class->get_property = gst_qt_jpeg_dec_get_property;
+
+    GstElementClass *element_class = GST_ELEMENT_CLASS(klass);
+    element_class->change_state = gst_qt_jpeg_dec_change_state;
+
+    /**
+     * GstQtJpegDec::max-threads
+     *
+     * How many frames are decoded at once, 0 for as many as there are
+     * cores. Each thread adds a frame interval to the latency. Read when
+     * going from READY to PAUSED.
+     **/
+    g_object_class_install_property(gobject_class, PROP_MAX_THREADS,
+        g_param_spec_uint("max-threads", "Maximum threads",
+                          "Frames decoded at the same time (0 = one per core)",
+                          0, 64, 0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    g_type_class_add_private (klass, sizeof (GstQtJpegDecPrivate));
+
+    gst_element_class_add_pad_template(
+            element_class, gst_static_pad_template_get(&sink_pad_template));
+    gst_element_class_add_pad_template(
+            element_class, gst_static_pad_template_get(&src_pad_template));
+
+    gst_element_class_set_details_simple(element_class,
+        "Qt JPEG decoder", "Codec/Decoder/Image",
+        "Decodes MJPEG with QImage, several frames at once",
+        "Kamoso developers");
+}
@@ -0,0 +1,45 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __GST_QT_JPEG_DEC_H__
+#define __GST_QT_JPEG_DEC_H__
+
+#include <gst/gst.h>
+
+#define GST_TYPE_QT_JPEG_DEC \
+    (gst_qt_jpeg_dec_get_type ())
+#define GST_QT_JPEG_DEC(obj) \
+    (G_TYPE_CHECK_INSTANCE_CAST ((obj), GST_TYPE_QT_JPEG_DEC, GstQtJpegDec))
+#define GST_IS_QT_JPEG_DEC(obj) \
+    (G_TYPE_CHECK_INSTANCE_TYPE ((obj), GST_TYPE_QT_JPEG_DEC))
+
+typedef struct _GstQtJpegDec GstQtJpegDec;
+typedef struct _GstQtJpegDecClass GstQtJpegDecClass;
+typedef struct _GstQtJpegDecPrivate GstQtJpegDecPrivate;
+
+struct _GstQtJpegDec
+{
+    GstElement parent_instance;
+    GstQtJpegDecPrivate *priv;
+};
+
+struct _GstQtJpegDecClass
+{
+    GstElementClass parent_class;
+};
+
+GType gst_qt_jpeg_dec_get_type (void);
+
+#endif /* __GST_QT_JPEG_DEC_H__ */
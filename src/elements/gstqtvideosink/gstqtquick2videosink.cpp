@@ -18,14 +18,17 @@
 #include "gstqtquick2videosink.h"
 #include "gstqtvideosinkplugin.h"
 #include "gstqtvideosinkmarshal.h"
+#include "qtquick2videosinkinterface.h"
 #include "delegates/qtquick2videosinkdelegate.h"
 
 #include <gst/video/colorbalance.h>
+#include <gst/video/gstvideometa.h>
+#include <gst/video/gstvideopool.h>
 
 #include <cstring>
 #include <QCoreApplication>
 
-#define CAPS_FORMATS "{ BGRA, BGRx, ARGB, xRGB, RGB, RGB16, BGR, v308, AYUV, YV12, I420 }"
+#define CAPS_FORMATS "{ BGRA, BGRx, ARGB, xRGB, RGB, RGB16, BGR, v308, AYUV, YV12, I420, YUY2, UYVY, YVYU, NV12, NV21, Y42B, Y444, GRAY8 }"
 
 #define GST_QT_QUICK2_VIDEO_SINK_GET_PRIVATE(obj) \
     (G_TYPE_INSTANCE_GET_PRIVATE ((obj), GST_TYPE_QT_QUICK2_VIDEO_SINK, GstQtQuick2VideoSinkPrivate))
@@ -44,6 +47,26 @@ G_DEFINE_TYPE_WITH_CODE (GstQtQuick2VideoSink, gst_qt_quick2_video_sink,
         G_IMPLEMENT_INTERFACE (GST_TYPE_COLOR_BALANCE,
                 gst_qt_quick2_video_sink_colorbalance_init));
 
+#define GST_TYPE_QT_QUICK2_VIDEO_SINK_EFFECT (gst_qt_quick2_video_sink_effect_get_type())
+
+static GType gst_qt_quick2_video_sink_effect_get_type()
+{
+    static GType type = 0;
+    static GEnumValue values[VideoEffect::Num_Types + 1];
+
+    if (g_once_init_enter(&type)) {
+        for (int i = 0; i < VideoEffect::Num_Types; i++) {
+            const char *name = VideoEffect::name(static_cast<VideoEffect::Type>(i));
+            values[i].value = i;
+            values[i].value_name = name;
+            values[i].value_nick = name;
+        }
+        //the last one stays zeroed
+        g_once_init_leave(&type, g_enum_register_static("GstQtQuick2VideoSinkEffect", values));
+    }
+    return type;
+}
+
 enum {
     PROP_0,
     PROP_PIXEL_ASPECT_RATIO,
@@ -52,6 +75,28 @@ enum {
     PROP_BRIGHTNESS,
     PROP_HUE,
     PROP_SATURATION,
+    PROP_USE_PBO,
+    PROP_REPLACED_FRAMES,
+    PROP_FRAMES_RECEIVED,
+    PROP_FRAMES_RENDERED,
+    PROP_UPLOAD_TIME_AVERAGE,
+    PROP_UPLOAD_TIME_P99,
+    PROP_LATENCY_AVERAGE,
+    PROP_LATENCY_P99,
+    PROP_DECODE_TIME_AVERAGE,
+    PROP_DECODE_TIME_P99,
+    PROP_ADAPTIVE_SIZE,
+    PROP_MIRROR,
+    PROP_ROTATION,
+    PROP_ZOOM,
+    PROP_PAN_X,
+    PROP_PAN_Y,
+    PROP_EFFECT,
+    PROP_COLOR_FILTER,
+    PROP_QOS,
+    PROP_PACING_LATENCY,
+    PROP_VISIBLE,
+    PROP_UPDATE_NODE_INTERFACE,
 };
 
 enum {
@@ -62,6 +107,20 @@ enum {
 
 static guint s_signals[LAST_SIGNAL] = { 0 };
 
+static gpointer gst_qt_quick2_video_sink_update_node_direct(GstElement *sink, gpointer node,
+                                                            gdouble x, gdouble y,
+                                                            gdouble w, gdouble h);
+static gpointer gst_qt_quick2_video_sink_update_node_in_window(GstElement *sink, gpointer node,
+                                                               gpointer window,
+                                                               gdouble x, gdouble y,
+                                                               gdouble w, gdouble h);
+
+static const GstQtQuick2VideoSinkInterface s_interface = {
+    GST_QT_QUICK2_VIDEO_SINK_INTERFACE_VERSION,
+    gst_qt_quick2_video_sink_update_node_direct,
+    gst_qt_quick2_video_sink_update_node_in_window
+};
+
 const char * const s_colorbalance_labels[] = {
     "contrast", "brightness", "hue", "saturation"
 };
@@ -83,6 +142,9 @@ gst_qt_quick2_video_sink_init (GstQtQuick2VideoSink *self)
     // delegate
     self->priv->delegate = new QtQuick2VideoSinkDelegate(GST_ELEMENT(self));
 
+    // the delegate sends QoS events from the render thread instead
+    gst_base_sink_set_qos_enabled(GST_BASE_SINK(self), FALSE);
+
     // colorbalance
     GstColorBalanceChannel *channel;
     self->priv->channels_list = NULL;
@@ -156,6 +218,45 @@ gst_qt_quick2_video_sink_set_property (GObject *object,
     case PROP_SATURATION:
         self->priv->delegate->setSaturation(g_value_get_int(value));
         break;
+    case PROP_USE_PBO:
+        self->priv->delegate->setUsePixelBuffers(g_value_get_boolean(value));
+        break;
+    case PROP_ADAPTIVE_SIZE:
+        self->priv->delegate->setAdaptiveSize(g_value_get_boolean(value));
+        break;
+    case PROP_MIRROR:
+        self->priv->delegate->setMirror(g_value_get_boolean(value));
+        break;
+    case PROP_ROTATION:
+        self->priv->delegate->setRotation(g_value_get_int(value));
+        break;
+    case PROP_ZOOM:
+        self->priv->delegate->setZoom(g_value_get_double(value));
+        break;
+    case PROP_PAN_X:
+        self->priv->delegate->setPanX(g_value_get_double(value));
+        break;
+    case PROP_PAN_Y:
+        self->priv->delegate->setPanY(g_value_get_double(value));
+        break;
+    case PROP_EFFECT:
+        self->priv->delegate->setEffect(static_cast<VideoEffect::Type>(g_value_get_enum(value)));
+        break;
+    case PROP_QOS:
+        self->priv->delegate->setQos(g_value_get_boolean(value));
+        break;
+    case PROP_PACING_LATENCY:
+        self->priv->delegate->setPacingLatency(g_value_get_uint64(value));
+        break;
+    case PROP_VISIBLE:
+        self->priv->delegate->setVisible(g_value_get_boolean(value));
+        break;
+    case PROP_COLOR_FILTER:
+        if (!self->priv->delegate->setColorFilter(g_value_get_string(value))) {
+            GST_ELEMENT_WARNING(self, RESOURCE, SETTINGS,
+                    ("Could not apply color filter \"%s\"", g_value_get_string(value)), (NULL));
+        }
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -197,6 +298,72 @@ gst_qt_quick2_video_sink_get_property (GObject *object,
     case PROP_SATURATION:
         g_value_set_int(value, self->priv->delegate->saturation());
         break;
+    case PROP_USE_PBO:
+        g_value_set_boolean(value, self->priv->delegate->usePixelBuffers());
+        break;
+    case PROP_ADAPTIVE_SIZE:
+        g_value_set_boolean(value, self->priv->delegate->adaptiveSize());
+        break;
+    case PROP_MIRROR:
+        g_value_set_boolean(value, self->priv->delegate->mirror());
+        break;
+    case PROP_ROTATION:
+        g_value_set_int(value, self->priv->delegate->rotation());
+        break;
+    case PROP_ZOOM:
+        g_value_set_double(value, self->priv->delegate->zoom());
+        break;
+    case PROP_PAN_X:
+        g_value_set_double(value, self->priv->delegate->panX());
+        break;
+    case PROP_PAN_Y:
+        g_value_set_double(value, self->priv->delegate->panY());
+        break;
+    case PROP_EFFECT:
+        g_value_set_enum(value, self->priv->delegate->effect());
+        break;
+    case PROP_QOS:
+        g_value_set_boolean(value, self->priv->delegate->qos());
+        break;
+    case PROP_PACING_LATENCY:
+        g_value_set_uint64(value, self->priv->delegate->pacingLatency());
+        break;
+    case PROP_VISIBLE:
+        g_value_set_boolean(value, self->priv->delegate->isVisible());
+        break;
+    case PROP_COLOR_FILTER:
+        g_value_set_string(value, self->priv->delegate->colorFilter().constData());
+        break;
+    case PROP_UPDATE_NODE_INTERFACE:
+        g_value_set_pointer(value, const_cast<GstQtQuick2VideoSinkInterface*>(&s_interface));
+        break;
+    case PROP_REPLACED_FRAMES:
+        g_value_set_uint(value, self->priv->delegate->statistics()->framesReplaced());
+        break;
+    case PROP_FRAMES_RECEIVED:
+        g_value_set_uint64(value, self->priv->delegate->statistics()->framesReceived());
+        break;
+    case PROP_FRAMES_RENDERED:
+        g_value_set_uint64(value, self->priv->delegate->statistics()->framesRendered());
+        break;
+    case PROP_UPLOAD_TIME_AVERAGE:
+        g_value_set_double(value, self->priv->delegate->statistics()->uploadTime().average);
+        break;
+    case PROP_UPLOAD_TIME_P99:
+        g_value_set_double(value, self->priv->delegate->statistics()->uploadTime().p99);
+        break;
+    case PROP_LATENCY_AVERAGE:
+        g_value_set_double(value, self->priv->delegate->statistics()->latency().average);
+        break;
+    case PROP_LATENCY_P99:
+        g_value_set_double(value, self->priv->delegate->statistics()->latency().p99);
+        break;
+    case PROP_DECODE_TIME_AVERAGE:
+        g_value_set_double(value, self->priv->delegate->statistics()->decodeTime().average);
+        break;
+    case PROP_DECODE_TIME_P99:
+        g_value_set_double(value, self->priv->delegate->statistics()->decodeTime().p99);
+        break;
     default:
         G_OBJECT_WARN_INVALID_PROPERTY_ID (object, property_id, pspec);
         break;
@@ -223,6 +390,33 @@ gst_qt_quick2_video_sink_change_state(GstElement *element,
     return GST_ELEMENT_CLASS (parent_class)->change_state (element, transition);
 }
 
+static GstCaps *
+gst_qt_quick2_video_sink_get_caps(GstBaseSink *sink, GstCaps *filter)
+{
+    GstQtQuick2VideoSink *self = GST_QT_QUICK2_VIDEO_SINK (sink);
+
+    GstCaps *caps = gst_pad_get_pad_template_caps(GST_BASE_SINK_PAD(sink));
+
+    //with adaptive-size, frames larger than the items are not worth it
+    const QSize size = self->priv->delegate->maximumFrameSize();
+    if (!size.isEmpty()) {
+        caps = gst_caps_make_writable(caps);
+        gst_caps_set_simple(caps,
+                            "width", GST_TYPE_INT_RANGE, 1, size.width(),
+                            "height", GST_TYPE_INT_RANGE, 1, size.height(),
+                            NULL);
+    }
+
+    if (filter) {
+        GstCaps *intersection = gst_caps_intersect_full(filter, caps, GST_CAPS_INTERSECT_FIRST);
+        gst_caps_unref(caps);
+        caps = intersection;
+    }
+
+    GST_LOG_OBJECT(self, "returning caps %" GST_PTR_FORMAT, caps);
+    return caps;
+}
+
 static gboolean
 gst_qt_quick2_video_sink_set_caps(GstBaseSink *sink, GstCaps *caps)
 {
@@ -235,22 +429,78 @@ gst_qt_quick2_video_sink_set_caps(GstBaseSink *sink, GstCaps *caps)
     //it should conform to the template caps formats, unless gstreamer
     //core has a bug.
     if (format.videoFormat() != GST_VIDEO_FORMAT_UNKNOWN) {
-        QCoreApplication::postEvent(self->priv->delegate,
-                                    new BaseDelegate::BufferFormatEvent(format));
+        //travels along with the following buffers
+        self->priv->delegate->setStreamFormat(format);
         return TRUE;
     } else {
         return FALSE;
     }
 }
 
+static gboolean
+gst_qt_quick2_video_sink_propose_allocation(GstBaseSink *sink, GstQuery *query)
+{
+    GstQtQuick2VideoSink *self = GST_QT_QUICK2_VIDEO_SINK (sink);
+
+    GstCaps *caps;
+    gboolean need_pool;
+    gst_query_parse_allocation(query, &caps, &need_pool);
+
+    if (!caps) {
+        GST_DEBUG_OBJECT(self, "no caps specified");
+        return FALSE;
+    }
+
+    GstVideoInfo info;
+    if (!gst_video_info_from_caps(&info, caps)) {
+        GST_DEBUG_OBJECT(self, "invalid caps specified");
+        return FALSE;
+    }
+
+    if (need_pool) {
+        GstBufferPool *pool = gst_video_buffer_pool_new();
+        GST_DEBUG_OBJECT(self, "offering pool %" GST_PTR_FORMAT, pool);
+
+        // the material reads the plane layout from the GstVideoMeta, so
+        // upstream may pad and align the planes as it likes
+        GstStructure *config = gst_buffer_pool_get_config(pool);
+        gst_buffer_pool_config_set_params(config, caps, info.size, 2, 0);
+        gst_buffer_pool_config_add_option(config, GST_BUFFER_POOL_OPTION_VIDEO_META);
+
+        if (!gst_buffer_pool_set_config(pool, config)) {
+            GST_WARNING_OBJECT(self, "failed to set the buffer pool configuration");
+            gst_object_unref(pool);
+            return FALSE;
+        }
+
+        // one buffer is always held by the delegate for repaints
+        gst_query_add_allocation_pool(query, pool, info.size, 2, 0);
+        gst_object_unref(pool);
+    }
+
+    gst_query_add_allocation_meta(query, GST_VIDEO_META_API_TYPE, NULL);
+    gst_query_add_allocation_meta(query, GST_VIDEO_CROP_META_API_TYPE, NULL);
+
+    return TRUE;
+}
+
 static GstFlowReturn
 gst_qt_quick2_video_sink_show_frame(GstVideoSink *sink, GstBuffer *buffer)
 {
     GstQtQuick2VideoSink *self = GST_QT_QUICK2_VIDEO_SINK (sink);
 
-    GST_TRACE_OBJECT(self, "Posting new buffer (%" GST_PTR_FORMAT ") for rendering.", buffer);
+    GST_TRACE_OBJECT(self, "Pushing new buffer (%" GST_PTR_FORMAT ") for rendering.", buffer);
 
-    QCoreApplication::postEvent(self->priv->delegate, new BaseDelegate::BufferEvent(buffer));
+    //the render thread compares it with the clock, for QoS and statistics
+    GstClockTime runningTime = GST_CLOCK_TIME_NONE;
+    if (GST_BUFFER_PTS_IS_VALID(buffer)) {
+        GST_OBJECT_LOCK(self);
+        runningTime = gst_segment_to_running_time(
+                &GST_BASE_SINK(sink)->segment, GST_FORMAT_TIME, GST_BUFFER_PTS(buffer));
+        GST_OBJECT_UNLOCK(self);
+    }
+
+    self->priv->delegate->pushBuffer(buffer, runningTime);
 
     return GST_FLOW_OK;
 }
@@ -265,6 +515,22 @@ gst_qt_quick2_video_sink_update_node(GstQtQuick2VideoSink *self, gpointer node,
                                               QRectF(x, y, w, h));
 }
 
+//the same, for callers of the interface below
+static gpointer
+gst_qt_quick2_video_sink_update_node_direct(GstElement *sink, gpointer node,
+                                            gdouble x, gdouble y, gdouble w, gdouble h)
+{
+    return gst_qt_quick2_video_sink_update_node(GST_QT_QUICK2_VIDEO_SINK(sink), node, x, y, w, h);
+}
+
+static gpointer
+gst_qt_quick2_video_sink_update_node_in_window(GstElement *sink, gpointer node, gpointer window,
+                                               gdouble x, gdouble y, gdouble w, gdouble h)
+{
+    return GST_QT_QUICK2_VIDEO_SINK(sink)->priv->delegate->updateNode(static_cast<QSGNode*>(node),
+            QRectF(x, y, w, h), static_cast<QQuickWindow*>(window));
+}
+
 //------------------------------
 
 static const GList *
@@ -344,7 +610,9 @@ gst_qt_quick2_video_sink_class_init (GstQtQuick2VideoSinkClass *klass)
     element_class->change_state = gst_qt_quick2_video_sink_change_state;
 
     GstBaseSinkClass *base_sink_class = GST_BASE_SINK_CLASS(klass);
+    base_sink_class->get_caps = gst_qt_quick2_video_sink_get_caps;
     base_sink_class->set_caps = gst_qt_quick2_video_sink_set_caps;
+    base_sink_class->propose_allocation = gst_qt_quick2_video_sink_propose_allocation;
 
     GstVideoSinkClass *video_sink_class = GST_VIDEO_SINK_CLASS(klass);
     video_sink_class->show_frame = gst_qt_quick2_video_sink_show_frame;
@@ -390,6 +658,268 @@ gst_qt_quick2_video_sink_class_init (GstQtQuick2VideoSinkClass *klass)
         g_param_spec_int("saturation", "Saturation", "The saturation of the video",
                          -100, 100, 0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
 
+    /**
+     * GstQtQuick2VideoSink::use-pbo
+     *
+     * If set to TRUE, frames are uploaded through a ring of pixel buffer
+     * objects, so that the render thread does not wait for the transfer
+     * to complete. This delays each frame by one repaint.
+     * Ignored if the OpenGL context does not support pixel buffer objects.
+     **/
+    g_object_class_install_property(gobject_class, PROP_USE_PBO,
+        g_param_spec_boolean("use-pbo", "Use pixel buffer objects",
+                             "Upload frames asynchronously through pixel buffer objects",
+                             FALSE, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::mirror
+     *
+     * If set to TRUE, the video is flipped horizontally, like a mirror.
+     * This only changes the texture coordinates, so it costs nothing.
+     **/
+    g_object_class_install_property(gobject_class, PROP_MIRROR,
+        g_param_spec_boolean("mirror", "Mirror",
+                             "Flip the video horizontally",
+                             FALSE, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::rotation
+     *
+     * Clockwise rotation of the video in degrees, rounded to the nearest
+     * multiple of 90. The video is rotated before being mirrored.
+     **/
+    g_object_class_install_property(gobject_class, PROP_ROTATION,
+        g_param_spec_int("rotation", "Rotation",
+                         "Clockwise rotation in degrees (0, 90, 180 or 270)",
+                         0, 270, 0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::zoom
+     *
+     * Digital zoom: only 1/zoom of the width and height of the video is
+     * shown, scaled up to fill the same area. Which part is shown is
+     * chosen with pan-x and pan-y.
+     **/
+    g_object_class_install_property(gobject_class, PROP_ZOOM,
+        g_param_spec_double("zoom", "Zoom", "Digital zoom factor",
+                            1.0, 16.0, 1.0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::pan-x
+     *
+     * The horizontal position of the zoomed in part, from -1 (left edge
+     * of the picture as displayed) to 1 (right edge).
+     **/
+    g_object_class_install_property(gobject_class, PROP_PAN_X,
+        g_param_spec_double("pan-x", "Horizontal pan",
+                            "Horizontal position of the zoomed in part (-1 to 1)",
+                            -1.0, 1.0, 0.0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::pan-y
+     *
+     * The vertical position of the zoomed in part, from -1 (top) to 1 (bottom).
+     **/
+    g_object_class_install_property(gobject_class, PROP_PAN_Y,
+        g_param_spec_double("pan-y", "Vertical pan",
+                            "Vertical position of the zoomed in part (-1 to 1)",
+                            -1.0, 1.0, 0.0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::effect
+     *
+     * A geometric effect applied by the fragment shader while drawing.
+     * Each one matches the geometrictransform element of the same name
+     * (bulge, pinch, twirl, stretch, square, kaleidoscope, mirror) with
+     * its default properties, so that a pipeline may drop that element
+     * and leave the work to the GPU.
+     **/
+    g_object_class_install_property(gobject_class, PROP_EFFECT,
+        g_param_spec_enum("effect", "Effect",
+                          "Geometric effect applied while drawing",
+                          GST_TYPE_QT_QUICK2_VIDEO_SINK_EFFECT, VideoEffect::None,
+                          static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::color-filter
+     *
+     * A chain of colour-only elements in gst-launch syntax, such as
+     * "videobalance saturation=0" or "coloreffects preset=sepia". When
+     * set, the chain is run once over a lattice of colours and the
+     * result is looked up by the shaders for every pixel drawn, which
+     * leaves the elements out of the pipeline. Elements whose output
+     * depends on anything but the colour of each pixel (position, other
+     * frames) cannot be represented this way. Empty to turn it off.
+     **/
+    g_object_class_install_property(gobject_class, PROP_COLOR_FILTER,
+        g_param_spec_string("color-filter", "Color filter",
+                            "Colour-only elements to apply as a lookup table",
+                            NULL, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::qos
+     *
+     * Overrides GstBaseSink::qos. The QoS events are sent when the render
+     * thread picks up a frame, with how late it is by then, rather than
+     * when the frame is handed over to it.
+     **/
+    g_object_class_override_property(gobject_class, PROP_QOS, "qos");
+
+    /**
+     * GstQtQuick2VideoSink::pacing-latency
+     *
+     * When not 0, frames are handed to the render thread this many
+     * nanoseconds ahead of their time and each is shown on the refresh
+     * closest to its timestamp, instead of on the first one after it
+     * arrived. More latency absorbs more jitter in the arrival of the
+     * frames; it is added to the latency of the pipeline (as render-delay)
+     * and should be at least a frame's duration.
+     **/
+    g_object_class_install_property(gobject_class, PROP_PACING_LATENCY,
+        g_param_spec_uint64("pacing-latency", "Pacing latency",
+                            "How early frames are queued to show them on time, in ns (0 = off)",
+                            0, GST_SECOND, 0, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::visible
+     *
+     * Whether any of the items showing this sink is on screen, as told by
+     * the application. While FALSE, buffers are still accepted, but the
+     * sink does not ask for them to be drawn, so nothing is uploaded; the
+     * latest one is shown when it becomes TRUE again.
+     **/
+    g_object_class_install_property(gobject_class, PROP_VISIBLE,
+        g_param_spec_boolean("visible", "Visible",
+                             "Whether the video is on screen",
+                             TRUE, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::update-node-interface
+     *
+     * A pointer to a constant #GstQtQuick2VideoSinkInterface, declared in
+     * qtquick2videosinkinterface.h, through which items can update their
+     * node without emitting ::update-node for every frame. It is the same
+     * for all the sinks, so reading it once is enough.
+     **/
+    g_object_class_install_property(gobject_class, PROP_UPDATE_NODE_INTERFACE,
+        g_param_spec_pointer("update-node-interface", "Update node interface",
+                             "Function table to call instead of the update-node signal",
+                             static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::adaptive-size
+     *
+     * If set to TRUE, the sink asks upstream for frames no larger than
+     * the items showing them, renegotiating its caps as they are resized.
+     * The limit grows as soon as the items do and shrinks only once they
+     * are less than half of it. This needs an element that can scale
+     * upstream, such as videoscale, or negotiation fails.
+     **/
+    g_object_class_install_property(gobject_class, PROP_ADAPTIVE_SIZE,
+        g_param_spec_boolean("adaptive-size", "Adaptive size",
+                             "Negotiate frames about the size they are displayed at",
+                             FALSE, static_cast<GParamFlags>(G_PARAM_READWRITE)));
+
+    /**
+     * GstQtQuick2VideoSink::replaced-frames
+     *
+     * The number of frames that were replaced by a newer one before the
+     * render thread got to display them.
+     **/
+    g_object_class_install_property(gobject_class, PROP_REPLACED_FRAMES,
+        g_param_spec_uint("replaced-frames", "Replaced frames",
+                          "Number of frames replaced before being displayed",
+                          0, G_MAXUINT, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::frames-received
+     *
+     * The number of frames that reached the sink since it was created.
+     **/
+    g_object_class_install_property(gobject_class, PROP_FRAMES_RECEIVED,
+        g_param_spec_uint64("frames-received", "Frames received",
+                            "Number of frames received from upstream",
+                            0, G_MAXUINT64, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::frames-rendered
+     *
+     * The number of frames that were handed to the scene graph for
+     * display. Together with frames-received and replaced-frames, this
+     * tells how many frames the render thread could not keep up with.
+     **/
+    g_object_class_install_property(gobject_class, PROP_FRAMES_RENDERED,
+        g_param_spec_uint64("frames-rendered", "Frames rendered",
+                            "Number of frames handed to the scene graph",
+                            0, G_MAXUINT64, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::upload-time-average
+     *
+     * The average time, in microseconds, that the render thread spent
+     * uploading each of the last 256 frames into textures. With use-pbo,
+     * this only covers the copy into the pixel buffer.
+     **/
+    g_object_class_install_property(gobject_class, PROP_UPLOAD_TIME_AVERAGE,
+        g_param_spec_double("upload-time-average", "Average upload time",
+                            "Average texture upload time of recent frames (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::upload-time-p99
+     *
+     * The 99th percentile of the upload times above, in microseconds.
+     **/
+    g_object_class_install_property(gobject_class, PROP_UPLOAD_TIME_P99,
+        g_param_spec_double("upload-time-p99", "99th percentile upload time",
+                            "99th percentile texture upload time of recent frames (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::latency-average
+     *
+     * How late, on average and in microseconds, the last 256 frames were
+     * picked up by the render thread, compared to the clock time their
+     * timestamp was due at. Frames without a timestamp are not counted.
+     **/
+    g_object_class_install_property(gobject_class, PROP_LATENCY_AVERAGE,
+        g_param_spec_double("latency-average", "Average latency",
+                            "Average delay between a frame's timestamp and its rendering (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::latency-p99
+     *
+     * The 99th percentile of the latencies above, in microseconds.
+     **/
+    g_object_class_install_property(gobject_class, PROP_LATENCY_P99,
+        g_param_spec_double("latency-p99", "99th percentile latency",
+                            "99th percentile delay between a frame's timestamp and its rendering (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::decode-time-average
+     *
+     * The average time, in microseconds, that the last 256 frames took to
+     * decode, as told by the decoder upstream. Only qtjpegdec tells; with
+     * it decoding several frames at once, this is the time of one frame
+     * on one thread.
+     **/
+    g_object_class_install_property(gobject_class, PROP_DECODE_TIME_AVERAGE,
+        g_param_spec_double("decode-time-average", "Average decode time",
+                            "Average decode time of recent frames (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
+    /**
+     * GstQtQuick2VideoSink::decode-time-p99
+     *
+     * The 99th percentile of the decode times above, in microseconds.
+     **/
+    g_object_class_install_property(gobject_class, PROP_DECODE_TIME_P99,
+        g_param_spec_double("decode-time-p99", "99th percentile decode time",
+                            "99th percentile decode time of recent frames (microseconds)",
+                            0, G_MAXDOUBLE, 0, static_cast<GParamFlags>(G_PARAM_READABLE)));
+
 
     /**
      * GstQtQuick2VideoSink::update-node
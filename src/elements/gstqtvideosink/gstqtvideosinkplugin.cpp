@@ -17,6 +17,7 @@
 
 #include "gstqtvideosinkplugin.h"
 #include "gstqtquick2videosink.h"
+#include "gstqtjpegdec.h"
 
 GST_DEBUG_CATEGORY(gst_qt_video_sink_debug);
 
@@ -35,6 +36,12 @@ static gboolean plugin_init(GstPlugin *plugin)
         return FALSE;
     }
 
+    if (!gst_element_register(plugin, "qtjpegdec",
+                GST_RANK_NONE, GST_TYPE_QT_JPEG_DEC)) {
+        GST_ERROR("Failed to register qtjpegdec");
+        return FALSE;
+    }
+
     return TRUE;
 }
 
@@ -0,0 +1,78 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "sharedvideomaterials.h"
+#include "videomaterial.h"
+
+#include <QOpenGLContext>
+
+SharedVideoMaterials::SharedVideoMaterials(const RenderStatistics::Ptr & statistics)
+    : m_statistics(statistics)
+{
+}
+
+SharedVideoMaterials::~SharedVideoMaterials()
+{
+    // every node holds a reference to this object as well
+    Q_ASSERT(m_references.isEmpty());
+}
+
+VideoMaterial *SharedVideoMaterials::acquire(const BufferFormat & format)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QMutexLocker l(&m_mutex);
+
+    QHash<QOpenGLContext*, Entry>::iterator it = m_current.find(context);
+    if (it != m_current.end() && it->format == format) {
+        m_references[it->material]++;
+        return it->material;
+    }
+
+    VideoMaterial *material = VideoMaterial::create(format);
+    if (!material)
+        return NULL;
+    material->setStatistics(m_statistics);
+
+    // nodes still drawing the previous format keep their material
+    // until they switch over
+    Entry entry = { material, format };
+    m_current.insert(context, entry);
+    m_references.insert(material, 1);
+    return material;
+}
+
+void SharedVideoMaterials::release(VideoMaterial *material)
+{
+    {
+        QMutexLocker l(&m_mutex);
+
+        QHash<VideoMaterial*, int>::iterator it = m_references.find(material);
+        Q_ASSERT(it != m_references.end());
+        if (--it.value() > 0)
+            return;
+        m_references.erase(it);
+
+        for (QHash<QOpenGLContext*, Entry>::iterator current = m_current.begin();
+             current != m_current.end(); ++current) {
+            if (current->material == material) {
+                m_current.erase(current);
+                break;
+            }
+        }
+    }
+
+    // deletes the textures, so the context must still be current
+    delete material;
+}
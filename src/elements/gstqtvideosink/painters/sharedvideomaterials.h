@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SHAREDVIDEOMATERIALS_H
+#define SHAREDVIDEOMATERIALS_H
+
+#include "../utils/bufferformat.h"
+#include "../utils/renderstatistics.h"
+
+#include <QHash>
+#include <QMutex>
+#include <QSharedPointer>
+
+class QOpenGLContext;
+class VideoMaterial;
+
+/**
+ * The materials of one sink, one per OpenGL context.
+ *
+ * All the nodes that a sink updates in the same context (several items
+ * showing the same surface in one window) draw with the same material,
+ * so each frame is uploaded to its textures only once. Nodes in other
+ * windows get a material of their own, since textures cannot be used
+ * outside of the context that created them.
+ *
+ * The materials are reference counted by the nodes and are deleted by
+ * the last one that releases them, on its render thread.
+ */
+class SharedVideoMaterials
+{
+public:
+    typedef QSharedPointer<SharedVideoMaterials> Ptr;
+
+    explicit SharedVideoMaterials(const RenderStatistics::Ptr & statistics);
+    ~SharedVideoMaterials();
+
+    // the material for frames of the given format in the current context,
+    // created if there is none yet; to be released once unused
+    VideoMaterial *acquire(const BufferFormat & format);
+    void release(VideoMaterial *material);
+
+private:
+    struct Entry
+    {
+        VideoMaterial *material;
+        BufferFormat format;
+    };
+
+    RenderStatistics::Ptr m_statistics;
+
+    // the windows of a sink may render on different threads
+    QMutex m_mutex;
+    QHash<QOpenGLContext*, Entry> m_current;
+    QHash<VideoMaterial*, int> m_references;
+
+    Q_DISABLE_COPY(SharedVideoMaterials)
+};
+
+#endif // SHAREDVIDEOMATERIALS_H
@@ -0,0 +1,403 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "softwareconverter.h"
+#include "../utils/colormatrix.h"
+
+#include <QtEndian>
+
+#if defined(__SSE2__) || defined(_M_X64) || (defined(_M_IX86_FP) && _M_IX86_FP >= 2)
+# include <emmintrin.h>
+# define SOFTWARECONVERTER_SSE2
+#endif
+
+// built with a target attribute and picked at run time, as distributions
+// do not build for AVX2
+#if defined(SOFTWARECONVERTER_SSE2) && defined(__GNUC__)
+# include <immintrin.h>
+# define SOFTWARECONVERTER_AVX2
+#endif
+
+#if defined(__ARM_NEON) && Q_BYTE_ORDER == Q_LITTLE_ENDIAN
+# include <arm_neon.h>
+# define SOFTWARECONVERTER_NEON
+#endif
+
+typedef SoftwareConverter::Coefficients Coefficients;
+
+static void convertRowScalar(const quint8 *c0, const quint8 *c1, const quint8 *c2,
+                             quint32 *dst, int width, const Coefficients & k)
+{
+    for (int i = 0; i < width; i++) {
+        int rgb[3];
+        for (int c = 0; c < 3; c++) {
+            const int value = k.matrix[c][0] * c0[i] + k.matrix[c][1] * c1[i]
+                            + k.matrix[c][2] * c2[i] + k.offset[c];
+            rgb[c] = qBound(0, value >> SoftwareConverter::Coefficient_Bits, 255);
+        }
+        dst[i] = 0xff000000 | (rgb[0] << 16) | (rgb[1] << 8) | rgb[2];
+    }
+}
+
+#ifdef SOFTWARECONVERTER_SSE2
+/* Eight pixels at a time. The components are widened to 16 bits and
+ * interleaved as (c0, c1) and (c2, 0) pairs, so that a multiply-add of each
+ * pair with the matching pair of coefficients does a whole row of the matrix
+ * in two instructions. The results saturate to 0..255 while narrowing. */
+static void convertRowSse2(const quint8 *c0, const quint8 *c1, const quint8 *c2,
+                           quint32 *dst, int width, const Coefficients & k)
+{
+    const __m128i zero = _mm_setzero_si128();
+    const __m128i alpha = _mm_set1_epi8(-1);
+
+    __m128i c01[3], c2z[3], offset[3];
+    for (int c = 0; c < 3; c++) {
+        c01[c] = _mm_set1_epi32(int(quint32(quint16(k.matrix[c][1])) << 16 | quint16(k.matrix[c][0])));
+        c2z[c] = _mm_set1_epi32(quint16(k.matrix[c][2]));
+        offset[c] = _mm_set1_epi32(k.offset[c]);
+    }
+
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        const __m128i x = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(c0 + i)), zero);
+        const __m128i y = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(c1 + i)), zero);
+        const __m128i z = _mm_unpacklo_epi8(_mm_loadl_epi64(reinterpret_cast<const __m128i*>(c2 + i)), zero);
+
+        const __m128i xyLow = _mm_unpacklo_epi16(x, y);
+        const __m128i xyHigh = _mm_unpackhi_epi16(x, y);
+        const __m128i zLow = _mm_unpacklo_epi16(z, zero);
+        const __m128i zHigh = _mm_unpackhi_epi16(z, zero);
+
+        __m128i rgb[3];
+        for (int c = 0; c < 3; c++) {
+            __m128i low = _mm_add_epi32(_mm_madd_epi16(xyLow, c01[c]), _mm_madd_epi16(zLow, c2z[c]));
+            __m128i high = _mm_add_epi32(_mm_madd_epi16(xyHigh, c01[c]), _mm_madd_epi16(zHigh, c2z[c]));
+            low = _mm_srai_epi32(_mm_add_epi32(low, offset[c]), SoftwareConverter::Coefficient_Bits);
+            high = _mm_srai_epi32(_mm_add_epi32(high, offset[c]), SoftwareConverter::Coefficient_Bits);
+            rgb[c] = _mm_packus_epi16(_mm_packs_epi32(low, high), zero);
+        }
+
+        // 0xffRRGGBB in memory order on little endian: B, G, R, A
+        const __m128i bg = _mm_unpacklo_epi8(rgb[2], rgb[1]);
+        const __m128i ra = _mm_unpacklo_epi8(rgb[0], alpha);
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i), _mm_unpacklo_epi16(bg, ra));
+        _mm_storeu_si128(reinterpret_cast<__m128i*>(dst + i + 4), _mm_unpackhi_epi16(bg, ra));
+    }
+
+    convertRowScalar(c0 + i, c1 + i, c2 + i, dst + i, width - i, k);
+}
+#endif
+
+#ifdef SOFTWARECONVERTER_AVX2
+// the same on sixteen pixels; the unpacking works within each 128-bit
+// half, so the two halves of the result are swapped into order at the end
+__attribute__((target("avx2")))
+static void convertRowAvx2(const quint8 *c0, const quint8 *c1, const quint8 *c2,
+                           quint32 *dst, int width, const Coefficients & k)
+{
+    const __m256i zero = _mm256_setzero_si256();
+    const __m256i alpha = _mm256_set1_epi8(-1);
+
+    __m256i c01[3], c2z[3], offset[3];
+    for (int c = 0; c < 3; c++) {
+        c01[c] = _mm256_set1_epi32(int(quint32(quint16(k.matrix[c][1])) << 16 | quint16(k.matrix[c][0])));
+        c2z[c] = _mm256_set1_epi32(quint16(k.matrix[c][2]));
+        offset[c] = _mm256_set1_epi32(k.offset[c]);
+    }
+
+    int i = 0;
+    for (; i + 16 <= width; i += 16) {
+        const __m256i x = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c0 + i)));
+        const __m256i y = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c1 + i)));
+        const __m256i z = _mm256_cvtepu8_epi16(_mm_loadu_si128(reinterpret_cast<const __m128i*>(c2 + i)));
+
+        // pixels 0-3 and 8-11, then 4-7 and 12-15
+        const __m256i xyLow = _mm256_unpacklo_epi16(x, y);
+        const __m256i xyHigh = _mm256_unpackhi_epi16(x, y);
+        const __m256i zLow = _mm256_unpacklo_epi16(z, zero);
+        const __m256i zHigh = _mm256_unpackhi_epi16(z, zero);
+
+        __m256i rgb[3];
+        for (int c = 0; c < 3; c++) {
+            __m256i low = _mm256_add_epi32(_mm256_madd_epi16(xyLow, c01[c]), _mm256_madd_epi16(zLow, c2z[c]));
+            __m256i high = _mm256_add_epi32(_mm256_madd_epi16(xyHigh, c01[c]), _mm256_madd_epi16(zHigh, c2z[c]));
+            low = _mm256_srai_epi32(_mm256_add_epi32(low, offset[c]), SoftwareConverter::Coefficient_Bits);
+            high = _mm256_srai_epi32(_mm256_add_epi32(high, offset[c]), SoftwareConverter::Coefficient_Bits);
+            // back in order: pixels 0-7, then 8-15
+            rgb[c] = _mm256_packus_epi16(_mm256_packs_epi32(low, high), zero);
+        }
+
+        const __m256i bg = _mm256_unpacklo_epi8(rgb[2], rgb[1]);
+        const __m256i ra = _mm256_unpacklo_epi8(rgb[0], alpha);
+        const __m256i low = _mm256_unpacklo_epi16(bg, ra);
+        const __m256i high = _mm256_unpackhi_epi16(bg, ra);
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i), _mm256_permute2x128_si256(low, high, 0x20));
+        _mm256_storeu_si256(reinterpret_cast<__m256i*>(dst + i + 8), _mm256_permute2x128_si256(low, high, 0x31));
+    }
+
+    convertRowScalar(c0 + i, c1 + i, c2 + i, dst + i, width - i, k);
+}
+#endif
+
+#ifdef SOFTWARECONVERTER_NEON
+static void convertRowNeon(const quint8 *c0, const quint8 *c1, const quint8 *c2,
+                           quint32 *dst, int width, const Coefficients & k)
+{
+    int i = 0;
+    for (; i + 8 <= width; i += 8) {
+        const int16x8_t x = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c0 + i)));
+        const int16x8_t y = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c1 + i)));
+        const int16x8_t z = vreinterpretq_s16_u16(vmovl_u8(vld1_u8(c2 + i)));
+
+        uint8x8x4_t bgra;
+        for (int c = 0; c < 3; c++) {
+            int32x4_t low = vdupq_n_s32(k.offset[c]);
+            low = vmlal_n_s16(low, vget_low_s16(x), k.matrix[c][0]);
+            low = vmlal_n_s16(low, vget_low_s16(y), k.matrix[c][1]);
+            low = vmlal_n_s16(low, vget_low_s16(z), k.matrix[c][2]);
+
+            int32x4_t high = vdupq_n_s32(k.offset[c]);
+            high = vmlal_n_s16(high, vget_high_s16(x), k.matrix[c][0]);
+            high = vmlal_n_s16(high, vget_high_s16(y), k.matrix[c][1]);
+            high = vmlal_n_s16(high, vget_high_s16(z), k.matrix[c][2]);
+
+            const int16x8_t value = vcombine_s16(
+                    vqmovn_s32(vshrq_n_s32(low, SoftwareConverter::Coefficient_Bits)),
+                    vqmovn_s32(vshrq_n_s32(high, SoftwareConverter::Coefficient_Bits)));
+            bgra.val[2 - c] = vqmovun_s16(value);
+        }
+        bgra.val[3] = vdup_n_u8(255);
+        vst4_u8(reinterpret_cast<quint8*>(dst + i), bgra);
+    }
+
+    convertRowScalar(c0 + i, c1 + i, c2 + i, dst + i, width - i, k);
+}
+#endif
+
+//------------------------------
+
+// where a component of the frame is, and how to step through it
+struct Component
+{
+    const quint8 *data;
+    int stride;
+    int pixelStride;
+    int widthShift;
+    int heightShift;
+    int depth;
+    int shift;
+};
+
+// components of less than eight bits, as in RGB16, in host order words
+static void gatherPacked(const quint8 *row, const int *offsets, int width,
+                         const Component & component, quint8 *dst)
+{
+    const int mask = (1 << component.depth) - 1;
+    for (int i = 0; i < width; i++) {
+        const int value = (qFromUnaligned<quint16>(row + offsets[i]) >> component.shift) & mask;
+        dst[i] = (value << (8 - component.depth)) | (value >> (2 * component.depth - 8));
+    }
+}
+
+static void gather(const quint8 *row, const int *offsets, int width, quint8 *dst)
+{
+    for (int i = 0; i < width; i++)
+        dst[i] = row[offsets[i]];
+}
+
+// the nearest of extent pixels to a texture coordinate
+static inline int sample(qreal coordinate, int extent)
+{
+    return qBound(0, int(coordinate * extent), extent - 1);
+}
+
+//------------------------------
+
+SoftwareConverter::SoftwareConverter()
+    : m_brightness(0), m_contrast(0), m_hue(0), m_saturation(0),
+      m_colorMatrixType(GST_VIDEO_COLOR_MATRIX_UNKNOWN),
+      m_convertRow(rowFunction())
+{
+    updateCoefficients();
+}
+
+//static
+bool SoftwareConverter::supportsFormat(GstVideoFormat format)
+{
+    const GstVideoFormatInfo *info = gst_video_format_get_info(format);
+    if (!info || GST_VIDEO_FORMAT_INFO_HAS_PALETTE(info) || GST_VIDEO_FORMAT_INFO_IS_TILED(info)
+        || GST_VIDEO_FORMAT_INFO_IS_COMPLEX(info)) {
+        return false;
+    }
+
+    for (guint c = 0; c < GST_VIDEO_FORMAT_INFO_N_COMPONENTS(info); c++) {
+        if (GST_VIDEO_FORMAT_INFO_DEPTH(info, c) > 8)
+            return false;
+    }
+    return true;
+}
+
+//static
+SoftwareConverter::RowFunction SoftwareConverter::rowFunction()
+{
+#ifdef SOFTWARECONVERTER_AVX2
+    if (__builtin_cpu_supports("avx2"))
+        return convertRowAvx2;
+#endif
+#if defined(SOFTWARECONVERTER_SSE2)
+    return convertRowSse2;
+#elif defined(SOFTWARECONVERTER_NEON)
+    return convertRowNeon;
+#else
+    return convertRowScalar;
+#endif
+}
+
+//static
+SoftwareConverter::RowFunction SoftwareConverter::scalarRowFunction()
+{
+    return convertRowScalar;
+}
+
+void SoftwareConverter::updateColors(int brightness, int contrast, int hue, int saturation)
+{
+    m_brightness = brightness;
+    m_contrast = contrast;
+    m_hue = hue;
+    m_saturation = saturation;
+    updateCoefficients();
+}
+
+void SoftwareConverter::updateCoefficients()
+{
+    const QMatrix4x4 matrix = colorMatrix(m_brightness, m_contrast, m_hue, m_saturation,
+                                          m_colorMatrixType);
+
+    // the matrix works on 0..1 and the components are 0..255, which only
+    // changes the scale of the offsets
+    const qreal one = 1 << Coefficient_Bits;
+    for (int row = 0; row < 3; row++) {
+        for (int column = 0; column < 3; column++) {
+            m_coefficients.matrix[row][column] =
+                    qBound(-32768, qRound(matrix(row, column) * one), 32767);
+        }
+        m_coefficients.offset[row] = qRound(matrix(row, 3) * 255 * one) + (1 << (Coefficient_Bits - 1));
+    }
+}
+
+bool SoftwareConverter::convert(GstBuffer *buffer, const BufferFormat & format,
+                                const QRectF & sourceRect, const QTransform & textureTransform,
+                                const QSize & size, QImage *image)
+{
+    if (size.isEmpty())
+        return false;
+
+    GstVideoInfo info = format.videoInfo();
+    GstVideoFrame frame;
+    if (!gst_video_frame_map(&frame, &info, buffer, GST_MAP_READ))
+        return false;
+
+    // gray is shown as is, like the materials do
+    const GstVideoColorMatrix colorMatrixType = format.videoFormat() == GST_VIDEO_FORMAT_GRAY8
+            ? GST_VIDEO_COLOR_MATRIX_RGB : format.colorMatrix();
+    if (colorMatrixType != m_colorMatrixType) {
+        m_colorMatrixType = colorMatrixType;
+        updateCoefficients();
+    }
+
+    if (image->size() != size || image->format() != QImage::Format_RGB32)
+        *image = QImage(size, QImage::Format_RGB32);
+
+    const int width = size.width();
+    const int height = size.height();
+    const int frameWidth = GST_VIDEO_FRAME_WIDTH(&frame);
+    const int frameHeight = GST_VIDEO_FRAME_HEIGHT(&frame);
+
+    // the transform only rotates by quarter turns, mirrors and scales, so
+    // each output row is either a row or a column of the source
+    const bool transposed = qFuzzyIsNull(textureTransform.m11());
+
+    // gray has one component, used for all three
+    const GstVideoFormatInfo *finfo = frame.info.finfo;
+    const guint components = GST_VIDEO_FORMAT_INFO_N_COMPONENTS(finfo);
+    Component component[3];
+    for (guint c = 0; c < 3; c++) {
+        const guint source = c < components ? c : 0;
+        const guint plane = GST_VIDEO_FORMAT_INFO_PLANE(finfo, source);
+        component[c].data = static_cast<const quint8*>(GST_VIDEO_FRAME_PLANE_DATA(&frame, plane))
+                          + GST_VIDEO_FORMAT_INFO_POFFSET(finfo, source);
+        component[c].stride = GST_VIDEO_FRAME_PLANE_STRIDE(&frame, plane);
+        component[c].pixelStride = GST_VIDEO_FORMAT_INFO_PSTRIDE(finfo, source);
+        component[c].widthShift = GST_VIDEO_FORMAT_INFO_W_SUB(finfo, source);
+        component[c].heightShift = GST_VIDEO_FORMAT_INFO_H_SUB(finfo, source);
+        component[c].depth = GST_VIDEO_FORMAT_INFO_DEPTH(finfo, source);
+        component[c].shift = GST_VIDEO_FORMAT_INFO_SHIFT(finfo, source);
+    }
+
+    // along a row of the output, only one source coordinate changes
+    bool contiguous[3];
+    for (int c = 0; c < 3; c++) {
+        m_offsets[c].resize(width);
+        m_components[c].resize(width);
+    }
+    for (int i = 0; i < width; i++) {
+        const QPointF p = textureTransform.map(QPointF(
+                sourceRect.x() + (i + 0.5) * sourceRect.width() / width, sourceRect.y()));
+        for (int c = 0; c < 3; c++) {
+            const Component & comp = component[c];
+            m_offsets[c][i] = transposed
+                    ? (sample(p.y(), frameHeight) >> comp.heightShift) * comp.stride
+                    : (sample(p.x(), frameWidth) >> comp.widthShift) * comp.pixelStride;
+        }
+    }
+    for (int c = 0; c < 3; c++) {
+        contiguous[c] = (component[c].depth == 8);
+        for (int i = 1; contiguous[c] && i < width; i++)
+            contiguous[c] = (m_offsets[c][i] == m_offsets[c][0] + i);
+    }
+
+    uchar *bits = image->bits();
+    const int bytesPerLine = image->bytesPerLine();
+
+    for (int j = 0; j < height; j++) {
+        const QPointF p = textureTransform.map(QPointF(
+                sourceRect.x(), sourceRect.y() + (j + 0.5) * sourceRect.height() / height));
+
+        const quint8 *rows[3];
+        for (int c = 0; c < 3; c++) {
+            const Component & comp = component[c];
+            const quint8 *row = comp.data + (transposed
+                    ? (sample(p.x(), frameWidth) >> comp.widthShift) * comp.pixelStride
+                    : (sample(p.y(), frameHeight) >> comp.heightShift) * comp.stride);
+
+            if (contiguous[c]) {
+                rows[c] = row + m_offsets[c][0];
+            } else {
+                quint8 *dst = m_components[c].data();
+                if (comp.depth == 8)
+                    gather(row, m_offsets[c].constData(), width, dst);
+                else
+                    gatherPacked(row, m_offsets[c].constData(), width, comp, dst);
+                rows[c] = dst;
+            }
+        }
+
+        m_convertRow(rows[0], rows[1], rows[2],
+                     reinterpret_cast<quint32*>(bits + j * bytesPerLine), width, m_coefficients);
+    }
+
+    gst_video_frame_unmap(&frame);
+    return true;
+}
@@ -0,0 +1,84 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SOFTWARECONVERTER_H
+#define SOFTWARECONVERTER_H
+
+#include "../utils/bufferformat.h"
+
+#include <QImage>
+#include <QTransform>
+#include <QVector>
+
+/**
+ * Turns frames into RGB32 images on the CPU, for the software scene graph.
+ *
+ * Each output pixel takes the nearest source pixel, so cropping, rotating,
+ * mirroring and downscaling are all done by picking the right ones, row by
+ * row. The colour conversion and the colour balance are a single fixed
+ * point matrix, applied with SSE2, AVX2 or NEON where the CPU has them.
+ */
+class SoftwareConverter
+{
+public:
+    SoftwareConverter();
+
+    static bool supportsFormat(GstVideoFormat format);
+
+    // GstColorBalance interface values, as for the materials
+    void updateColors(int brightness, int contrast, int hue, int saturation);
+
+    // fills image, of the given size, with the part of the frame that
+    // sourceRect and textureTransform select, as VideoNode::updateGeometry()
+    // takes them. False if the buffer could not be read
+    bool convert(GstBuffer *buffer, const BufferFormat & format,
+                 const QRectF & sourceRect, const QTransform & textureTransform,
+                 const QSize & size, QImage *image);
+
+    // the matrix in fixed point, for components from 0 to 255
+    static const int Coefficient_Bits = 11;
+    struct Coefficients
+    {
+        qint16 matrix[3][3];
+        qint32 offset[3];
+    };
+
+    // converts a row of width pixels, given as three rows of components,
+    // into 0xffRRGGBB values
+    typedef void (*RowFunction)(const quint8 *c0, const quint8 *c1, const quint8 *c2,
+                                quint32 *dst, int width, const Coefficients & k);
+
+    // the fastest one this CPU can run, and the plain one it must match
+    static RowFunction rowFunction();
+    static RowFunction scalarRowFunction();
+
+private:
+    void updateCoefficients();
+
+    int m_brightness;
+    int m_contrast;
+    int m_hue;
+    int m_saturation;
+    GstVideoColorMatrix m_colorMatrixType;
+    Coefficients m_coefficients;
+    RowFunction m_convertRow;
+
+    // per output column, where each component is, relative to the row
+    QVector<int> m_offsets[3];
+    // components picked from rows that are not contiguous
+    QVector<quint8> m_components[3];
+};
+
+#endif // SOFTWARECONVERTER_H
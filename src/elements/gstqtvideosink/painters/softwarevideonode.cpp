@@ -0,0 +1,113 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "softwarevideonode.h"
+
+#include <QElapsedTimer>
+#include <QtQuick/QQuickWindow>
+#include <QtQuick/QSGImageNode>
+#include <QtQuick/QSGRectangleNode>
+
+// how many pixels of the frame a side of the picture covers, given the
+// normalized points at its two ends
+static int sourcePixels(const QTransform & textureTransform, const QPointF & from,
+                        const QPointF & to, const QSize & frameSize)
+{
+    const QPointF delta = textureTransform.map(to) - textureTransform.map(from);
+    return qRound(qAbs(delta.x()) * frameSize.width() + qAbs(delta.y()) * frameSize.height());
+}
+
+SoftwareVideoNode::SoftwareVideoNode(QQuickWindow *window)
+    : colorsVersion(0)
+    , m_window(window)
+    , m_background(window->createRectangleNode())
+    , m_picture(window->createImageNode())
+    , m_buffer(NULL)
+    , m_colorsChanged(false)
+{
+    m_background->setColor(Qt::black);
+    appendChildNode(m_background);
+
+    m_picture->setFiltering(QSGTexture::Linear);
+}
+
+SoftwareVideoNode::~SoftwareVideoNode()
+{
+    if (!m_picture->parent())
+        delete m_picture;
+    if (m_buffer)
+        gst_buffer_unref(m_buffer);
+}
+
+void SoftwareVideoNode::setBlack(const QRectF & targetArea)
+{
+    m_background->setRect(targetArea);
+
+    if (m_picture->parent())
+        removeChildNode(m_picture);
+    gst_buffer_replace(&m_buffer, NULL);
+}
+
+void SoftwareVideoNode::updateColors(int brightness, int contrast, int hue, int saturation)
+{
+    m_converter.updateColors(brightness, contrast, hue, saturation);
+    m_colorsChanged = true;
+}
+
+void SoftwareVideoNode::setCurrentFrame(GstBuffer *buffer, const BufferFormat & format,
+                                        const PaintAreas & areas,
+                                        const QTransform & textureTransform,
+                                        qreal devicePixelRatio,
+                                        const RenderStatistics::Ptr & statistics)
+{
+    m_background->setRect(areas.targetArea);
+
+    // no larger than the frame, which the renderer scales up more cheaply
+    const QRectF & source = areas.sourceRect;
+    const QSize frameSize = format.frameSize();
+    const QSize size(
+        qMax(1, qMin(qRound(areas.videoArea.width() * devicePixelRatio),
+                     sourcePixels(textureTransform, source.topLeft(), source.topRight(), frameSize))),
+        qMax(1, qMin(qRound(areas.videoArea.height() * devicePixelRatio),
+                     sourcePixels(textureTransform, source.topLeft(), source.bottomLeft(), frameSize))));
+
+    if (buffer != m_buffer || size != m_image.size() || source != m_sourceRect
+        || textureTransform != m_textureTransform || m_colorsChanged) {
+        QElapsedTimer timer;
+        timer.start();
+
+        if (!m_converter.convert(buffer, format, source, textureTransform, size, &m_image)) {
+            setBlack(areas.targetArea);
+            return;
+        }
+
+        QSGTexture *texture = m_window->createTextureFromImage(m_image);
+        m_picture->setTexture(texture);
+        m_texture.reset(texture);
+
+        if (statistics)
+            statistics->frameUploaded(timer.nsecsElapsed());
+
+        gst_buffer_replace(&m_buffer, buffer);
+        m_sourceRect = source;
+        m_textureTransform = textureTransform;
+        m_colorsChanged = false;
+    }
+
+    m_picture->setRect(areas.videoArea);
+    m_picture->setSourceRect(QRectF(QPointF(), m_image.size()));
+    if (!m_picture->parent())
+        appendChildNode(m_picture);
+}
@@ -0,0 +1,71 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SOFTWAREVIDEONODE_H
+#define SOFTWAREVIDEONODE_H
+
+#include "softwareconverter.h"
+#include "../utils/renderstatistics.h"
+
+#include <QtQuick/QSGNode>
+#include <QScopedPointer>
+
+class QQuickWindow;
+class QSGImageNode;
+class QSGRectangleNode;
+class QSGTexture;
+
+/**
+ * What VideoNode is for the OpenGL scene graph, for the software one:
+ * the frame is converted on the CPU into an image node, over a black
+ * rectangle that covers the rest of the item.
+ */
+class SoftwareVideoNode : public QSGNode
+{
+public:
+    explicit SoftwareVideoNode(QQuickWindow *window);
+    ~SoftwareVideoNode();
+
+    // with no frame, only the black rectangle is shown
+    void setBlack(const QRectF & targetArea);
+
+    void updateColors(int brightness, int contrast, int hue, int saturation);
+
+    // converts the frame again unless the image already shows it like that;
+    // the other arguments are those of VideoNode::updateGeometry()
+    void setCurrentFrame(GstBuffer *buffer, const BufferFormat & format,
+                         const PaintAreas & areas, const QTransform & textureTransform,
+                         qreal devicePixelRatio, const RenderStatistics::Ptr & statistics);
+
+    // the colorsVersion of the sink's properties last applied
+    quint32 colorsVersion;
+
+private:
+    QQuickWindow *m_window;
+    QSGRectangleNode *m_background;
+    QSGImageNode *m_picture; // a child only while there is a frame
+    QScopedPointer<QSGTexture> m_texture;
+
+    SoftwareConverter m_converter;
+    QImage m_image;
+
+    // what m_image holds
+    GstBuffer *m_buffer;
+    QRectF m_sourceRect;
+    QTransform m_textureTransform;
+    bool m_colorsChanged;
+};
+
+#endif // SOFTWAREVIDEONODE_H
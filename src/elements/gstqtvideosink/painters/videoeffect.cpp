@@ -0,0 +1,155 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "videoeffect.h"
+
+static const char * const qtvideosink_glsl_noEffect =
+    "varying highp vec2 qt_TexCoord;\n"
+    "highp vec2 effectTexCoord(highp vec2 coord) { return coord; }\n"
+    "lowp float effectVisible(highp vec2 coord) { return 1.0; }\n";
+
+/* The elements compute the source of every output pixel (x, y) in pixel
+ * units, then copy the pixel at the truncated source coordinates. The
+ * effect only has to define effectMap() the same way. */
+#define QTVIDEOSINK_GLSL_EFFECT(map) \
+    "uniform highp vec2 frameSize;\n" \
+    "varying highp vec2 qt_TexCoord;\n" \
+    "const highp float pi = 3.14159265358979;\n" \
+    "highp vec2 center() { return 0.5 * frameSize; }\n" \
+    "highp float radius() { return 0.35 * 0.5 * length(frameSize); }\n" \
+    map \
+    "highp vec2 effectPixel(highp vec2 coord)\n" \
+    "{\n" \
+    "    highp vec2 source = effectMap(floor(coord * frameSize));\n" \
+    "    return sign(source) * floor(abs(source));\n" \
+    "}\n" \
+    "highp vec2 effectTexCoord(highp vec2 coord)\n" \
+    "{\n" \
+    "    return (effectPixel(coord) + 0.5) / frameSize;\n" \
+    "}\n" \
+    "lowp float effectVisible(highp vec2 coord)\n" \
+    "{\n" \
+    "    highp vec2 pixel = effectPixel(coord);\n" \
+    "    return step(0.0, min(pixel.x, pixel.y))\n" \
+    "         * step(pixel.x, frameSize.x - 1.0) * step(pixel.y, frameSize.y - 1.0);\n" \
+    "}\n"
+
+// zoom = 3.0
+static const char * const qtvideosink_glsl_bulgeEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 norm = 2.0 * (pixel / frameSize - 0.5);\n"
+    "    highp float r = sqrt(0.5 * dot(norm, norm));\n"
+    "    highp float scale = 1.0 / (3.0 + (1.0 - 3.0) * smoothstep(0.0, 0.35, r));\n"
+    "    return 0.5 * (norm * scale + 1.0) * frameSize;\n"
+    "}\n");
+
+// intensity = 0.5
+static const char * const qtvideosink_glsl_pinchEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 d = pixel - center();\n"
+    "    highp float distance = dot(d, d);\n"
+    "    highp float radius2 = radius() * radius();\n"
+    "    if (distance > radius2 || distance == 0.0)\n"
+    "        return pixel;\n"
+    "    highp float t = pow(sin(pi * 0.5 * sqrt(distance / radius2)), -0.5);\n"
+    "    return center() + d * t;\n"
+    "}\n");
+
+// angle = pi
+static const char * const qtvideosink_glsl_twirlEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 d = pixel - center();\n"
+    "    highp float distance = dot(d, d);\n"
+    "    if (distance > radius() * radius() || distance == 0.0)\n"
+    "        return pixel;\n"
+    "    highp float r = sqrt(distance);\n"
+    "    highp float a = atan(d.y, d.x) + pi * (radius() - r) / radius();\n"
+    "    return center() + r * vec2(cos(a), sin(a));\n"
+    "}\n");
+
+// intensity = 0.5
+static const char * const qtvideosink_glsl_stretchEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 norm = 2.0 * (pixel / frameSize - 0.5);\n"
+    "    highp float r = sqrt(0.5 * dot(norm, norm));\n"
+    "    highp float a = 1.0 + (3.0 - 1.0) * 0.5;\n"
+    "    highp float scale = a - (a - 1.0) * smoothstep(0.0, 0.35, r);\n"
+    "    return 0.5 * (norm * scale + 1.0) * frameSize;\n"
+    "}\n");
+
+// width = 0.5, height = 0.5, zoom = 2.0
+static const char * const qtvideosink_glsl_squareEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 norm = 2.0 * pixel / frameSize - 1.0;\n"
+    "    norm *= (1.0 / 2.0) * (1.0 + (2.0 - 1.0)\n"
+    "            * smoothstep(vec2(0.5 - 0.125), vec2(0.5 + 0.125), abs(norm)));\n"
+    "    return 0.5 * (norm + 1.0) * frameSize;\n"
+    "}\n");
+
+// sides = 3, angle = angle2 = 0
+static const char * const qtvideosink_glsl_kaleidoscopeEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp float triangle(highp float x)\n"
+    "{\n"
+    "    highp float r = mod(x, 1.0);\n"
+    "    return 2.0 * (r < 0.5 ? r : 1.0 - r);\n"
+    "}\n"
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp vec2 d = pixel - center();\n"
+    "    highp float r = length(d);\n"
+    "    highp float theta = r > 0.0 ? atan(d.y, d.x) : 0.0;\n"
+    "    theta = triangle(theta / pi * 3.0 * 0.5);\n"
+    "    highp float radiusc = radius() / cos(theta);\n"
+    "    r = radiusc * triangle(r / radiusc);\n"
+    "    return center() + r * vec2(cos(theta), sin(theta));\n"
+    "}\n");
+
+// mode = left
+static const char * const qtvideosink_glsl_mirrorEffect = QTVIDEOSINK_GLSL_EFFECT(
+    "highp vec2 effectMap(highp vec2 pixel)\n"
+    "{\n"
+    "    highp float halfWidth = frameSize.x / 2.0 - 1.0;\n"
+    "    return vec2(pixel.x > halfWidth ? frameSize.x - 1.0 - pixel.x : pixel.x, pixel.y);\n"
+    "}\n");
+
+#undef QTVIDEOSINK_GLSL_EFFECT
+
+const char *VideoEffect::name(Type type)
+{
+    static const char * const names[Num_Types] = {
+        "none", "bulge", "pinch", "twirl", "stretch", "square", "kaleidoscope", "mirror"
+    };
+    return names[type];
+}
+
+const char *VideoEffect::fragmentShader(Type type)
+{
+    static const char * const shaders[Num_Types] = {
+        qtvideosink_glsl_noEffect,
+        qtvideosink_glsl_bulgeEffect,
+        qtvideosink_glsl_pinchEffect,
+        qtvideosink_glsl_twirlEffect,
+        qtvideosink_glsl_stretchEffect,
+        qtvideosink_glsl_squareEffect,
+        qtvideosink_glsl_kaleidoscopeEffect,
+        qtvideosink_glsl_mirrorEffect,
+    };
+    return shaders[type];
+}
@@ -0,0 +1,53 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef VIDEOEFFECT_H
+#define VIDEOEFFECT_H
+
+/**
+ * Geometric effects that the fragment shaders can apply while drawing,
+ * instead of a geometrictransform element upstream.
+ *
+ * Each one reproduces the element of the same name with its default
+ * properties: the output pixel is mapped to a source pixel with the
+ * same formula, the source coordinates are truncated and pixels mapped
+ * outside of the frame are black.
+ */
+class VideoEffect
+{
+public:
+    enum Type {
+        None,
+        Bulge,
+        Pinch,
+        Twirl,
+        Stretch,
+        Square,
+        Kaleidoscope,
+        Mirror
+    };
+    static const int Num_Types = Mirror + 1;
+
+    // the name of the element that is reproduced; "none" for None
+    static const char *name(Type type);
+
+    // GLSL that declares qt_TexCoord and defines, for the fragment shaders,
+    //   highp vec2 effectTexCoord(highp vec2 coord): where to sample instead of coord
+    //   lowp float effectVisible(highp vec2 coord): 0.0 where the pixel is black
+    // Needs the frame size in pixels in the frameSize uniform.
+    static const char *fragmentShader(Type type);
+};
+
+#endif // VIDEOEFFECT_H
@@ -17,11 +17,45 @@
 */
 
 #include "videomaterial.h"
+#include "../gstqtvideosinkplugin.h"
+#include "../utils/colormatrix.h"
 
-#include <qmath.h>
+#include <QElapsedTimer>
 #include <QOpenGLContext>
+#include <QOpenGLExtraFunctions>
 #include <QtQuick/QSGMaterialShader>
 
+#ifndef GL_RGBA8
+# define GL_RGBA8 0x8058
+#endif
+#ifndef GL_RGB8
+# define GL_RGB8 0x8051
+#endif
+#ifndef GL_RED
+# define GL_RED 0x1903
+#endif
+#ifndef GL_RG
+# define GL_RG 0x8227
+#endif
+#ifndef GL_R8
+# define GL_R8 0x8229
+#endif
+#ifndef GL_RG8
+# define GL_RG8 0x822B
+#endif
+#ifndef GL_UNPACK_ROW_LENGTH
+# define GL_UNPACK_ROW_LENGTH 0x0CF2
+#endif
+#ifndef GL_PIXEL_UNPACK_BUFFER
+# define GL_PIXEL_UNPACK_BUFFER 0x88EC
+#endif
+#ifndef GL_MAP_WRITE_BIT
+# define GL_MAP_WRITE_BIT 0x0002
+#endif
+#ifndef GL_MAP_INVALIDATE_BUFFER_BIT
+# define GL_MAP_INVALIDATE_BUFFER_BIT 0x0008
+#endif
+
 static const char * const qtvideosink_glsl_vertexShader =
     "uniform highp mat4 qt_Matrix;                      \n"
     "attribute highp vec4 qt_VertexPosition;            \n"
@@ -32,17 +66,42 @@ static const char * const qtvideosink_glsl_vertexShader =
     "    gl_Position = qt_Matrix * qt_VertexPosition;   \n"
     "}";
 
+/* The fragment shaders are prefixed with one of the VideoEffect shaders,
+ * which declares qt_TexCoord and moves the point to sample; the pixels
+ * that an effect maps outside of the frame are black. */
+#define QTVIDEOSINK_GLSL_FRAG_COLOR \
+    "mix(vec4(0.0, 0.0, 0.0, 1.0), colorLookup(colorMatrix * color), effectVisible(qt_TexCoord)) * opacity"
+
+static const char * const qtvideosink_glsl_noColorLookup =
+    "highp vec4 colorLookup(highp vec4 color) { return color; }\n";
+
+/* See ColorLookupTable for the layout. Red and green are interpolated by
+ * the texture unit, blue between the two nearest slices. */
+static const char * const qtvideosink_glsl_colorLookup =
+    "uniform sampler2D lookupTexture;\n"
+    "uniform highp float lookupSize;\n"
+    "highp vec4 colorLookup(highp vec4 color)\n"
+    "{\n"
+    "    highp vec3 lattice = clamp(color.rgb, 0.0, 1.0) * (lookupSize - 1.0);\n"
+    "    highp float slice = floor(lattice.b);\n"
+    "    highp float nextSlice = min(slice + 1.0, lookupSize - 1.0);\n"
+    "    highp vec2 point = (lattice.rg + 0.5) / vec2(lookupSize * lookupSize, lookupSize);\n"
+    "    highp vec3 low = texture2D(lookupTexture, point + vec2(slice / lookupSize, 0.0)).rgb;\n"
+    "    highp vec3 high = texture2D(lookupTexture, point + vec2(nextSlice / lookupSize, 0.0)).rgb;\n"
+    "    return vec4(mix(low, high, lattice.b - slice), color.a);\n"
+    "}\n";
+
 inline const char * const qtvideosink_glsl_bgrxFragmentShader()
 {
     return
     "uniform sampler2D rgbTexture;\n"
     "uniform lowp float opacity;\n"
     "uniform mediump mat4 colorMatrix;\n"
-    "varying highp vec2 qt_TexCoord;\n"
     "void main(void)\n"
     "{\n"
-    "    highp vec4 color = vec4(texture2D(rgbTexture, qt_TexCoord.st).bgr, 1.0);\n"
-    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n"
+    "    highp vec4 color = vec4(texture2D(rgbTexture, coord).bgr, 1.0);\n"
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n"
     "}\n";
 }
 
@@ -52,11 +111,11 @@ inline const char * const qtvideosink_glsl_xrgbFragmentShader()
     "uniform sampler2D rgbTexture;\n"
     "uniform lowp float opacity;\n"
     "uniform mediump mat4 colorMatrix;\n"
-    "varying highp vec2 qt_TexCoord;\n"
     "void main(void)\n"
     "{\n"
-    "    highp vec4 color = vec4(texture2D(rgbTexture, qt_TexCoord.st).gba, 1.0);\n"
-    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n"
+    "    highp vec4 color = vec4(texture2D(rgbTexture, coord).gba, 1.0);\n"
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n"
     "}\n";
 }
 
@@ -66,11 +125,11 @@ inline const char * const qtvideosink_glsl_rgbxFragmentShader()
     "uniform sampler2D rgbTexture;\n"
     "uniform lowp float opacity;\n"
     "uniform mediump mat4 colorMatrix;\n"
-    "varying highp vec2 qt_TexCoord;\n"
     "void main(void)\n"
     "{\n"
-    "    highp vec4 color = vec4(texture2D(rgbTexture, qt_TexCoord.st).rgb, 1.0);\n"
-    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n"
+    "    highp vec4 color = vec4(texture2D(rgbTexture, coord).rgb, 1.0);\n"
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n"
     "}\n";
 }
 
@@ -82,18 +141,107 @@ inline const char * const qtvideosink_glsl_yuvPlanarFragmentShader()
     "uniform sampler2D vTexture;\n"
     "uniform mediump mat4 colorMatrix;\n"
     "uniform lowp float opacity;\n"
-    "varying highp vec2 qt_TexCoord;\n"
     "void main(void)\n"
     "{\n"
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n"
     "    highp vec4 color = vec4(\n"
-    "           texture2D(yTexture, qt_TexCoord.st).r,\n"
-    "           texture2D(uTexture, qt_TexCoord.st).r,\n"
-    "           texture2D(vTexture, qt_TexCoord.st).r,\n"
+    "           texture2D(yTexture, coord).r,\n"
+    "           texture2D(uTexture, coord).r,\n"
+    "           texture2D(vTexture, coord).r,\n"
     "           1.0);\n"
-    "    gl_FragColor = colorMatrix * color * opacity;\n"
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n"
+    "}\n";
+}
+
+/* Semi-planar formats keep the interleaved chroma in a two channel
+ * texture, read back as .rg from GL_RG or as .ra from GL_LUMINANCE_ALPHA. */
+#define QTVIDEOSINK_GLSL_YUV_SEMIPLANAR(u, v) \
+    "uniform sampler2D yTexture;\n" \
+    "uniform sampler2D uvTexture;\n" \
+    "uniform mediump mat4 colorMatrix;\n" \
+    "uniform lowp float opacity;\n" \
+    "void main(void)\n" \
+    "{\n" \
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n" \
+    "    highp vec4 uv = texture2D(uvTexture, coord);\n" \
+    "    highp vec4 color = vec4(\n" \
+    "           texture2D(yTexture, coord).r,\n" \
+    "           uv." u ",\n" \
+    "           uv." v ",\n" \
+    "           1.0);\n" \
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n" \
+    "}\n"
+
+inline const char * const qtvideosink_glsl_nv12FragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV_SEMIPLANAR("r", "g");
+}
+
+inline const char * const qtvideosink_glsl_nv12LuminanceFragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV_SEMIPLANAR("r", "a");
+}
+
+inline const char * const qtvideosink_glsl_nv21FragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV_SEMIPLANAR("g", "r");
+}
+
+inline const char * const qtvideosink_glsl_nv21LuminanceFragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV_SEMIPLANAR("a", "r");
+}
+
+inline const char * const qtvideosink_glsl_grayFragmentShader()
+{
+    return
+    "uniform sampler2D yTexture;\n"
+    "uniform lowp float opacity;\n"
+    "uniform mediump mat4 colorMatrix;\n"
+    "void main(void)\n"
+    "{\n"
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n"
+    "    highp vec4 color = vec4(texture2D(yTexture, coord).rrr, 1.0);\n"
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n"
     "}\n";
 }
 
+/* Packed 4:2:2 formats are uploaded as an RGBA texture of half the frame
+ * width, each texel holding two luma samples and the chroma pair they
+ * share. The luma sample is picked by the parity of the pixel column. */
+#define QTVIDEOSINK_GLSL_YUV422_PACKED(y0, u, y1, v) \
+    "uniform sampler2D rgbTexture;\n" \
+    "uniform highp float frameWidth;\n" \
+    "uniform lowp float opacity;\n" \
+    "uniform mediump mat4 colorMatrix;\n" \
+    "void main(void)\n" \
+    "{\n" \
+    "    highp vec2 coord = effectTexCoord(qt_TexCoord);\n" \
+    "    highp vec4 texel = texture2D(rgbTexture, coord);\n" \
+    "    highp float odd = step(1.0, mod(coord.s * frameWidth, 2.0));\n" \
+    "    highp vec4 color = vec4(\n" \
+    "           mix(texel." y0 ", texel." y1 ", odd),\n" \
+    "           texel." u ",\n" \
+    "           texel." v ",\n" \
+    "           1.0);\n" \
+    "    gl_FragColor = " QTVIDEOSINK_GLSL_FRAG_COLOR ";\n" \
+    "}\n"
+
+inline const char * const qtvideosink_glsl_yuy2FragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV422_PACKED("r", "g", "b", "a");
+}
+
+inline const char * const qtvideosink_glsl_uyvyFragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV422_PACKED("g", "r", "a", "b");
+}
+
+inline const char * const qtvideosink_glsl_yvyuFragmentShader()
+{
+    return QTVIDEOSINK_GLSL_YUV422_PACKED("r", "a", "b", "g");
+}
+
 class VideoMaterialShader : public QSGMaterialShader
 {
 public:
@@ -103,8 +251,11 @@ public:
         Q_UNUSED(oldMaterial);
 
         VideoMaterial *material = static_cast<VideoMaterial *>(newMaterial);
-        if (m_id_rgbTexture > 0) {
+        if (m_id_rgbTexture >= 0) {
             program()->setUniformValue(m_id_rgbTexture, 0);
+        } else if (m_id_uvTexture >= 0) {
+            program()->setUniformValue(m_id_yTexture, 0);
+            program()->setUniformValue(m_id_uvTexture, 1);
         } else {
             program()->setUniformValue(m_id_yTexture, 0);
             program()->setUniformValue(m_id_uTexture, 1);
@@ -120,8 +271,23 @@ public:
         if (state.isMatrixDirty())
             program()->setUniformValue(m_id_matrix, state.combinedMatrix());
 
+        if (m_id_frameWidth >= 0)
+            program()->setUniformValue(m_id_frameWidth, GLfloat(material->m_frameWidth));
+
+        if (m_id_frameSize >= 0) {
+            program()->setUniformValue(m_id_frameSize,
+                GLfloat(GST_VIDEO_INFO_WIDTH(&material->m_videoInfo)),
+                GLfloat(GST_VIDEO_INFO_HEIGHT(&material->m_videoInfo)));
+        }
+
         program()->setUniformValue(m_id_colorMatrix, material->m_colorMatrix);
 
+        if (m_id_lookupTexture >= 0) {
+            program()->setUniformValue(m_id_lookupTexture, VideoMaterial::Lookup_Texture_Unit);
+            program()->setUniformValue(m_id_lookupSize,
+                GLfloat(material->m_colorLookupTable->size()));
+        }
+
         material->bind();
     }
 
@@ -141,8 +307,13 @@ protected:
         m_id_yTexture = program()->uniformLocation("yTexture");
         m_id_uTexture = program()->uniformLocation("uTexture");
         m_id_vTexture = program()->uniformLocation("vTexture");
+        m_id_uvTexture = program()->uniformLocation("uvTexture");
         m_id_colorMatrix = program()->uniformLocation("colorMatrix");
         m_id_opacity = program()->uniformLocation("opacity");
+        m_id_frameWidth = program()->uniformLocation("frameWidth");
+        m_id_frameSize = program()->uniformLocation("frameSize");
+        m_id_lookupTexture = program()->uniformLocation("lookupTexture");
+        m_id_lookupSize = program()->uniformLocation("lookupSize");
     }
 
     virtual const char *vertexShader() const {
@@ -154,102 +325,183 @@ protected:
     int m_id_yTexture;
     int m_id_uTexture;
     int m_id_vTexture;
+    int m_id_uvTexture;
     int m_id_colorMatrix;
     int m_id_opacity;
+    int m_id_frameWidth;
+    int m_id_frameSize;
+    int m_id_lookupTexture;
+    int m_id_lookupSize;
 };
 
 template <const char * const (*FragmentShader)()>
 class VideoMaterialShaderImpl : public VideoMaterialShader
 {
+public:
+    VideoMaterialShaderImpl(VideoEffect::Type effect, bool colorLookup)
+        : m_source(QByteArray(VideoEffect::fragmentShader(effect))
+                   + (colorLookup ? qtvideosink_glsl_colorLookup : qtvideosink_glsl_noColorLookup)
+                   + FragmentShader())
+    {}
+
 protected:
     virtual const char *fragmentShader() const {
-        return FragmentShader();
+        return m_source.constData();
     }
+
+private:
+    const QByteArray m_source;
 };
 
 template <const char * const (*FragmentShader)()>
 class VideoMaterialImpl : public VideoMaterial
 {
 public:
+    // one program per format, effect and use of a lookup table
     virtual QSGMaterialType *type() const {
-        static QSGMaterialType theType;
-        return &theType;
+        static QSGMaterialType theTypes[VideoEffect::Num_Types][2];
+        return &theTypes[effect()][colorLookupTable() ? 1 : 0];
     }
 
     virtual QSGMaterialShader *createShader() const {
-        return new VideoMaterialShaderImpl<FragmentShader>;
+        return new VideoMaterialShaderImpl<FragmentShader>(effect(), colorLookupTable());
     }
 };
 
+template <const char * const (*FragmentShader)()>
+static VideoMaterial *createVideoMaterial()
+{
+    return new VideoMaterialImpl<FragmentShader>;
+}
+
+typedef VideoMaterial *(*VideoMaterialFactory)();
+
+/* Everything create() needs to know about a format. The planes themselves
+ * (count, subsampling, strides, offsets) come from the GstVideoInfo; this
+ * only says which shader reads them and how each plane is stored. */
+struct VideoMaterial::FormatInfo
+{
+    GstVideoFormat format;
+    VideoMaterialFactory create;          // with GL_RED / GL_RG textures
+    VideoMaterialFactory createLuminance; // with GL_LUMINANCE(_ALPHA) textures
+    GLint filter;
+    TextureKind planes[GST_VIDEO_MAX_PLANES];
+};
+
+#define QTVIDEOSINK_FORMAT(format, shader, filter, ...) \
+    { GST_VIDEO_FORMAT_##format, \
+      createVideoMaterial<qtvideosink_glsl_##shader##FragmentShader>, \
+      createVideoMaterial<qtvideosink_glsl_##shader##FragmentShader>, \
+      filter, { __VA_ARGS__ } }
+
+#define QTVIDEOSINK_FORMAT_RG(format, shader, filter, ...) \
+    { GST_VIDEO_FORMAT_##format, \
+      createVideoMaterial<qtvideosink_glsl_##shader##FragmentShader>, \
+      createVideoMaterial<qtvideosink_glsl_##shader##LuminanceFragmentShader>, \
+      filter, { __VA_ARGS__ } }
+
+const VideoMaterial::FormatInfo *VideoMaterial::formatInfo(GstVideoFormat format)
+{
+    static const FormatInfo formats[] = {
+        QTVIDEOSINK_FORMAT(BGRx, bgrx, GL_LINEAR, TextureRgba),
+        QTVIDEOSINK_FORMAT(BGRA, bgrx, GL_LINEAR, TextureRgba),
+        QTVIDEOSINK_FORMAT(BGR, bgrx, GL_LINEAR, TextureRgb),
+        QTVIDEOSINK_FORMAT(xRGB, xrgb, GL_LINEAR, TextureRgba),
+        QTVIDEOSINK_FORMAT(ARGB, xrgb, GL_LINEAR, TextureRgba),
+        QTVIDEOSINK_FORMAT(AYUV, xrgb, GL_LINEAR, TextureRgba),
+        QTVIDEOSINK_FORMAT(RGB, rgbx, GL_LINEAR, TextureRgb),
+        QTVIDEOSINK_FORMAT(v308, rgbx, GL_LINEAR, TextureRgb),
+        QTVIDEOSINK_FORMAT(RGB16, rgbx, GL_LINEAR, TextureRgb565),
+
+        QTVIDEOSINK_FORMAT(I420, yuvPlanar, GL_LINEAR,
+                           TextureOneChannel, TextureOneChannel, TextureOneChannel),
+        QTVIDEOSINK_FORMAT(YV12, yuvPlanar, GL_LINEAR,
+                           TextureOneChannel, TextureOneChannel, TextureOneChannel),
+        QTVIDEOSINK_FORMAT(Y42B, yuvPlanar, GL_LINEAR,
+                           TextureOneChannel, TextureOneChannel, TextureOneChannel),
+        QTVIDEOSINK_FORMAT(Y444, yuvPlanar, GL_LINEAR,
+                           TextureOneChannel, TextureOneChannel, TextureOneChannel),
+        QTVIDEOSINK_FORMAT_RG(NV12, nv12, GL_LINEAR, TextureOneChannel, TextureTwoChannel),
+        QTVIDEOSINK_FORMAT_RG(NV21, nv21, GL_LINEAR, TextureOneChannel, TextureTwoChannel),
+        QTVIDEOSINK_FORMAT(GRAY8, gray, GL_LINEAR, TextureOneChannel),
+
+        // interpolating between texels would blend the luma of
+        // neighbouring pixel pairs into the chroma channels
+        QTVIDEOSINK_FORMAT(YUY2, yuy2, GL_NEAREST, TextureRgba),
+        QTVIDEOSINK_FORMAT(UYVY, uyvy, GL_NEAREST, TextureRgba),
+        QTVIDEOSINK_FORMAT(YVYU, yvyu, GL_NEAREST, TextureRgba),
+    };
+
+    for (uint i = 0; i < sizeof(formats) / sizeof(formats[0]); i++) {
+        if (formats[i].format == format)
+            return &formats[i];
+    }
+    return NULL;
+}
+
+#undef QTVIDEOSINK_FORMAT
+#undef QTVIDEOSINK_FORMAT_RG
+
+static bool hasTextureRg(QOpenGLContext *context)
+{
+    if (context->isOpenGLES())
+        return context->format().majorVersion() >= 3;
+
+    return context->format().majorVersion() >= 3
+        || context->hasExtension(QByteArrayLiteral("GL_ARB_texture_rg"));
+}
+
 VideoMaterial *VideoMaterial::create(const BufferFormat & format)
 {
-    VideoMaterial *material = NULL;
-
-    switch (format.videoFormat()) {
-    // BGRx
-    case GST_VIDEO_FORMAT_BGRx:
-    case GST_VIDEO_FORMAT_BGRA:
-        material = new VideoMaterialImpl<qtvideosink_glsl_bgrxFragmentShader>;
-        material->initRgbTextureInfo(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, format.frameSize());
-        break;
-    case GST_VIDEO_FORMAT_BGR:
-        material = new VideoMaterialImpl<qtvideosink_glsl_bgrxFragmentShader>;
-        material->initRgbTextureInfo(GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, format.frameSize());
-        break;
-
-    // xRGB
-    case GST_VIDEO_FORMAT_xRGB:
-    case GST_VIDEO_FORMAT_ARGB:
-    case GST_VIDEO_FORMAT_AYUV:
-        material = new VideoMaterialImpl<qtvideosink_glsl_xrgbFragmentShader>;
-        material->initRgbTextureInfo(GL_RGBA, GL_RGBA, GL_UNSIGNED_BYTE, format.frameSize());
-        break;
-
-    // RGBx
-    case GST_VIDEO_FORMAT_RGB:
-    case GST_VIDEO_FORMAT_v308:
-        material = new VideoMaterialImpl<qtvideosink_glsl_rgbxFragmentShader>;
-        material->initRgbTextureInfo(GL_RGB, GL_RGB, GL_UNSIGNED_BYTE, format.frameSize());
-        break;
-    case GST_VIDEO_FORMAT_RGB16:
-        material = new VideoMaterialImpl<qtvideosink_glsl_rgbxFragmentShader>;
-        material->initRgbTextureInfo(GL_RGB, GL_RGB, GL_UNSIGNED_SHORT_5_6_5, format.frameSize());
-        break;
-
-    // YUV 420 planar
-    case GST_VIDEO_FORMAT_I420:
-    case GST_VIDEO_FORMAT_YV12:
-        material = new VideoMaterialImpl<qtvideosink_glsl_yuvPlanarFragmentShader>;
-        material->initYuv420PTextureInfo(
-            (format.videoFormat() == GST_VIDEO_FORMAT_YV12) /* uvSwapped */,
-            format.frameSize());
-        break;
-
-    default:
+    const FormatInfo *entry = formatInfo(format.videoFormat());
+    if (!entry) {
         Q_ASSERT(false);
-        break;
+        return NULL;
     }
 
-    material->init(format.colorMatrix());
+    const bool textureRg = hasTextureRg(QOpenGLContext::currentContext());
+    const GstVideoInfo videoInfo = format.videoInfo();
+
+    VideoMaterial *material = textureRg ? entry->create() : entry->createLuminance();
+    material->initTextureInfo(videoInfo, entry->planes, entry->filter, textureRg);
+
+    // gray is rendered as is, whatever colorimetry upstream announced
+    material->init(GST_VIDEO_INFO_IS_GRAY(&videoInfo)
+                   ? GST_VIDEO_COLOR_MATRIX_RGB : format.colorMatrix());
     return material;
 }
 
 VideoMaterial::VideoMaterial() :
     m_frame(0),
+    m_frameGeneration(0),
+    m_uploadedGeneration(0),
     m_textureCount(0),
-    m_textureFormat(0),
-    m_textureInternalFormat(0),
-    m_textureType(0),
-    m_colorMatrixType(GST_VIDEO_COLOR_MATRIX_UNKNOWN)
+    m_textureFilter(GL_LINEAR),
+    m_hasUnpackRowLength(false),
+    m_frameWidth(0),
+    m_usePixelBuffers(false),
+    m_pixelBufferSize(0),
+    m_pixelBufferIndex(0),
+    m_colorMatrixType(GST_VIDEO_COLOR_MATRIX_UNKNOWN),
+    m_effect(VideoEffect::None),
+    m_lookupTextureId(0),
+    m_lookupTextureDirty(false)
 {
     memset(m_textureIds, 0, sizeof(m_textureIds));
+    memset(m_textures, 0, sizeof(m_textures));
+    gst_video_info_init(&m_videoInfo);
+    memset(m_pixelBufferIds, 0, sizeof(m_pixelBufferIds));
     setFlag(Blending, false);
 }
 
 VideoMaterial::~VideoMaterial()
 {
-    if (!m_textureSize.isEmpty())
+    if (m_textureCount > 0)
         glDeleteTextures(m_textureCount, m_textureIds);
+    if (m_pixelBufferIds[0])
+        glDeleteBuffers(Num_Pixel_Buffers, m_pixelBufferIds);
+    if (m_lookupTextureId)
+        glDeleteTextures(1, &m_lookupTextureId);
     gst_buffer_replace(&m_frame, NULL);
 }
 
@@ -265,187 +517,379 @@ int VideoMaterial::compare(const QSGMaterial *other) const
         return m_textureIds[2] - m->m_textureIds[2];
 }
 
-void VideoMaterial::initRgbTextureInfo(
-        GLenum internalFormat, GLuint format, GLenum type, const QSize &size)
-{
-#ifndef QT_OPENGL_ES
-    //make sure we get 8 bits per component, at least on the desktop GL where we can
-    switch(internalFormat) {
-    case GL_RGBA:
-        internalFormat = GL_RGBA8;
-        break;
-    case GL_RGB:
-        internalFormat = GL_RGB8;
-        break;
-    default:
-        break;
-    }
-#endif
-
-    m_textureInternalFormat = internalFormat;
-    m_textureFormat = format;
-    m_textureType = type;
-    m_textureCount = 1;
-    m_textureWidths[0] = size.width();
-    m_textureHeights[0] = size.height();
-    m_textureOffsets[0] = 0;
-}
-
-void VideoMaterial::initYuv420PTextureInfo(bool uvSwapped, const QSize &size)
+void VideoMaterial::initTextureInfo(const GstVideoInfo &videoInfo,
+        const TextureKind *planeKinds, GLint filter, bool textureRg)
 {
-    int bytesPerLine = (size.width() + 3) & ~3;
-    int bytesPerLine2 = (size.width() / 2 + 3) & ~3;
+    const GstVideoFormatInfo *finfo = videoInfo.finfo;
+
+    // ES2 only accepts the unsized internal formats
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    const bool sizedFormats = !context->isOpenGLES() || context->format().majorVersion() >= 3;
+
+    m_videoInfo = videoInfo;
+    m_textureFilter = filter;
+    m_textureCount = 0;
+
+    for (uint c = 0; c < GST_VIDEO_FORMAT_INFO_N_COMPONENTS(finfo); c++) {
+        const int plane = GST_VIDEO_FORMAT_INFO_PLANE(finfo, c);
+
+        int i = 0;
+        while (i < m_textureCount && m_textures[i].plane != plane)
+            i++;
+
+        if (i == m_textureCount) {
+            Q_ASSERT(m_textureCount < Num_Texture_IDs);
+            Texture &texture = m_textures[m_textureCount++];
+            texture.plane = plane;
+            texture.height = GST_VIDEO_INFO_COMP_HEIGHT(&videoInfo, c);
+            texture.width = 0;
+
+            switch (planeKinds[plane]) {
+            case TextureRgba:
+                texture.bytesPerTexel = 4;
+                texture.format = GL_RGBA;
+                texture.type = GL_UNSIGNED_BYTE;
+                texture.sizedFormat = GL_RGBA8;
+                break;
+            case TextureRgb:
+                texture.bytesPerTexel = 3;
+                texture.format = GL_RGB;
+                texture.type = GL_UNSIGNED_BYTE;
+                texture.sizedFormat = GL_RGB8;
+                break;
+            case TextureRgb565:
+                texture.bytesPerTexel = 2;
+                texture.format = GL_RGB;
+                texture.type = GL_UNSIGNED_SHORT_5_6_5;
+                texture.sizedFormat = 0;
+                break;
+            case TextureOneChannel:
+                texture.bytesPerTexel = 1;
+                texture.format = textureRg ? GL_RED : GL_LUMINANCE;
+                texture.type = GL_UNSIGNED_BYTE;
+                texture.sizedFormat = textureRg ? GL_R8 : 0;
+                break;
+            case TextureTwoChannel:
+                texture.bytesPerTexel = 2;
+                texture.format = textureRg ? GL_RG : GL_LUMINANCE_ALPHA;
+                texture.type = GL_UNSIGNED_BYTE;
+                texture.sizedFormat = textureRg ? GL_RG8 : 0;
+                break;
+            default:
+                Q_ASSERT(false);
+                break;
+            }
+
+            texture.internalFormat = (sizedFormats && texture.sizedFormat)
+                                   ? texture.sizedFormat : texture.format;
+        }
 
-    m_textureInternalFormat = GL_LUMINANCE;
-    m_textureFormat = GL_LUMINANCE;
-    m_textureType = GL_UNSIGNED_BYTE;
-    m_textureCount = 3;
-    m_textureWidths[0] = bytesPerLine;
-    m_textureHeights[0] = size.height();
-    m_textureOffsets[0] = 0;
-    m_textureWidths[1] = bytesPerLine2;
-    m_textureHeights[1] = size.height() / 2;
-    m_textureOffsets[1] = bytesPerLine * size.height();
-    m_textureWidths[2] = bytesPerLine2;
-    m_textureHeights[2] = size.height() / 2;
-    m_textureOffsets[2] = bytesPerLine * size.height() + bytesPerLine2 * size.height()/2;
+        // all the components of a plane must fit in a row of texels
+        Texture &texture = m_textures[i];
+        const int rowBytes = GST_VIDEO_INFO_COMP_WIDTH(&videoInfo, c)
+                           * GST_VIDEO_INFO_COMP_PSTRIDE(&videoInfo, c);
+        texture.width = qMax(texture.width,
+            (rowBytes + texture.bytesPerTexel - 1) / texture.bytesPerTexel);
+    }
 
-    if (uvSwapped)
-      qSwap (m_textureOffsets[1], m_textureOffsets[2]);
+    // the number of frame pixels covered by a row of the first texture;
+    // differs from the frame width only for packed 4:2:2
+    m_frameWidth = m_textures[0].width * m_textures[0].bytesPerTexel
+                 / GST_VIDEO_INFO_COMP_PSTRIDE(&videoInfo, 0);
 }
 
 void VideoMaterial::init(GstVideoColorMatrix colorMatrixType)
 {
     initializeOpenGLFunctions();
+
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    m_hasUnpackRowLength = !context->isOpenGLES() || context->format().majorVersion() >= 3;
+
     glGenTextures(m_textureCount, m_textureIds);
+    allocateTextures();
     m_colorMatrixType = colorMatrixType;
     updateColors(0, 0, 0, 0);
 }
 
-void VideoMaterial::setCurrentFrame(GstBuffer *buffer)
+static bool hasImmutableTextureStorage(QOpenGLContext *context)
+{
+    if (context->isOpenGLES())
+        return context->format().majorVersion() >= 3;
+
+    return context->format().version() >= qMakePair(4, 2)
+        || context->hasExtension(QByteArrayLiteral("GL_ARB_texture_storage"));
+}
+
+/* The material is recreated whenever the BufferFormat changes, so the
+ * texture dimensions are fixed for its whole lifetime. Allocate the
+ * storage and set the sampling parameters once here; bindTexture()
+ * then only has to replace the contents. */
+void VideoMaterial::allocateTextures()
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    QOpenGLExtraFunctions *extra = NULL;
+    if (hasImmutableTextureStorage(context))
+        extra = context->extraFunctions();
+
+    for (int i = 0; i < m_textureCount; i++) {
+        const Texture &texture = m_textures[i];
+
+        glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, m_textureFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, m_textureFilter);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+
+        if (extra && texture.sizedFormat) {
+            extra->glTexStorage2D(GL_TEXTURE_2D, 1, texture.sizedFormat,
+                                  texture.width, texture.height);
+        } else {
+            glTexImage2D(GL_TEXTURE_2D, 0, texture.internalFormat,
+                         texture.width, texture.height, 0,
+                         texture.format, texture.type, NULL);
+        }
+    }
+
+    glBindTexture(GL_TEXTURE_2D, 0);
+}
+
+quint64 VideoMaterial::setCurrentFrame(GstBuffer *buffer)
 {
     QMutexLocker lock(&m_frameMutex);
-    gst_buffer_replace(&m_frame, buffer);
+    if (gst_buffer_replace(&m_frame, buffer))
+        m_frameGeneration++;
+
+    return m_frameGeneration;
+}
+
+void VideoMaterial::setUsePixelBuffers(bool use)
+{
+    //called again by every node sharing this material
+    if (use == m_usePixelBuffers)
+        return;
+
+    m_usePixelBuffers = use;
+}
+
+void VideoMaterial::setEffect(VideoEffect::Type effect)
+{
+    m_effect = effect;
+}
+
+void VideoMaterial::setColorLookupTable(const ColorLookupTable::Ptr & table)
+{
+    if (table == m_colorLookupTable)
+        return;
+
+    m_colorLookupTable = table;
+    m_lookupTextureDirty = true;
+}
+
+void VideoMaterial::setStatistics(const RenderStatistics::Ptr & statistics)
+{
+    m_statistics = statistics;
 }
 
 void VideoMaterial::updateColors(int brightness, int contrast, int hue, int saturation)
 {
-    const qreal b = brightness / 200.0;
-    const qreal c = contrast / 100.0 + 1.0;
-    const qreal h = hue / 100.0;
-    const qreal s = saturation / 100.0 + 1.0;
-
-    const qreal cosH = qCos(M_PI * h);
-    const qreal sinH = qSin(M_PI * h);
-
-    const qreal h11 =  0.787 * cosH - 0.213 * sinH + 0.213;
-    const qreal h21 = -0.213 * cosH + 0.143 * sinH + 0.213;
-    const qreal h31 = -0.213 * cosH - 0.787 * sinH + 0.213;
-
-    const qreal h12 = -0.715 * cosH - 0.715 * sinH + 0.715;
-    const qreal h22 =  0.285 * cosH + 0.140 * sinH + 0.715;
-    const qreal h32 = -0.715 * cosH + 0.715 * sinH + 0.715;
-
-    const qreal h13 = -0.072 * cosH + 0.928 * sinH + 0.072;
-    const qreal h23 = -0.072 * cosH - 0.283 * sinH + 0.072;
-    const qreal h33 =  0.928 * cosH + 0.072 * sinH + 0.072;
-
-    const qreal sr = (1.0 - s) * 0.3086;
-    const qreal sg = (1.0 - s) * 0.6094;
-    const qreal sb = (1.0 - s) * 0.0820;
-
-    const qreal sr_s = sr + s;
-    const qreal sg_s = sg + s;
-    const qreal sb_s = sr + s;
-
-    const float m4 = (s + sr + sg + sb) * (0.5 - 0.5 * c + b);
-
-    m_colorMatrix(0, 0) = c * (sr_s * h11 + sg * h21 + sb * h31);
-    m_colorMatrix(0, 1) = c * (sr_s * h12 + sg * h22 + sb * h32);
-    m_colorMatrix(0, 2) = c * (sr_s * h13 + sg * h23 + sb * h33);
-    m_colorMatrix(0, 3) = m4;
-
-    m_colorMatrix(1, 0) = c * (sr * h11 + sg_s * h21 + sb * h31);
-    m_colorMatrix(1, 1) = c * (sr * h12 + sg_s * h22 + sb * h32);
-    m_colorMatrix(1, 2) = c * (sr * h13 + sg_s * h23 + sb * h33);
-    m_colorMatrix(1, 3) = m4;
-
-    m_colorMatrix(2, 0) = c * (sr * h11 + sg * h21 + sb_s * h31);
-    m_colorMatrix(2, 1) = c * (sr * h12 + sg * h22 + sb_s * h32);
-    m_colorMatrix(2, 2) = c * (sr * h13 + sg * h23 + sb_s * h33);
-    m_colorMatrix(2, 3) = m4;
-
-    m_colorMatrix(3, 0) = 0.0;
-    m_colorMatrix(3, 1) = 0.0;
-    m_colorMatrix(3, 2) = 0.0;
-    m_colorMatrix(3, 3) = 1.0;
-
-    switch (m_colorMatrixType) {
-    case GST_VIDEO_COLOR_MATRIX_BT709:
-        m_colorMatrix *= QMatrix4x4(
-                    1.164,  0.000,  1.793, -0.5727,
-                    1.164, -0.534, -0.213,  0.3007,
-                    1.164,  2.115,  0.000, -1.1302,
-                    0.0,    0.000,  0.000,  1.0000);
-        break;
-    case GST_VIDEO_COLOR_MATRIX_BT601:
-        m_colorMatrix *= QMatrix4x4(
-                    1.164,  0.000,  1.596, -0.8708,
-                    1.164, -0.392, -0.813,  0.5296,
-                    1.164,  2.017,  0.000, -1.081,
-                    0.0,    0.000,  0.000,  1.0000);
-        break;
-    default:
-        break;
-    }
+    m_colorMatrix = colorMatrix(brightness, contrast, hue, saturation, m_colorMatrixType);
 }
 
 void VideoMaterial::bind()
 {
     GstBuffer *frame = NULL;
+    quint64 generation = 0;
+
+    // first, so that the frame's textures leave unit 0 active
+    if (m_colorLookupTable)
+        bindColorLookupTable();
 
     m_frameMutex.lock();
-    if (m_frame)
-      frame = gst_buffer_ref(m_frame);
+    if (m_frame && m_frameGeneration != m_uploadedGeneration) {
+        frame = gst_buffer_ref(m_frame);
+        generation = m_frameGeneration;
+    }
     m_frameMutex.unlock();
 
     if (frame) {
-        GstMapInfo info;
-        gst_buffer_map(frame, &info, GST_MAP_READ);
-        glActiveTexture(GL_TEXTURE1);
-        bindTexture(1, info.data);
-        glActiveTexture(GL_TEXTURE2);
-        bindTexture(2, info.data);
-        glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-        bindTexture(0, info.data);
-        gst_buffer_unmap(frame, &info);
+        QElapsedTimer timer;
+        timer.start();
+        uploadFrame(frame);
+        if (m_statistics)
+            m_statistics->frameUploaded(timer.nsecsElapsed());
         gst_buffer_unref(frame);
+        m_uploadedGeneration = generation;
+    } else {
+        // the textures already hold the current frame, e.g. when the
+        // scene is repainted for an animation on top of the video
+        for (int i = m_textureCount - 1; i >= 0; i--) {
+            glActiveTexture(GL_TEXTURE0 + i);
+            glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
+        }
+    }
+}
+
+void VideoMaterial::bindColorLookupTable()
+{
+    glActiveTexture(GL_TEXTURE0 + Lookup_Texture_Unit);
+
+    if (!m_lookupTextureId) {
+        glGenTextures(1, &m_lookupTextureId);
+        m_lookupTextureDirty = true;
+    }
+    glBindTexture(GL_TEXTURE_2D, m_lookupTextureId);
+
+    if (m_lookupTextureDirty) {
+        glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+        glTexImage2D(GL_TEXTURE_2D, 0, GL_RGBA,
+                     m_colorLookupTable->width(), m_colorLookupTable->height(), 0,
+                     GL_RGBA, GL_UNSIGNED_BYTE, m_colorLookupTable->data().constData());
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
+        glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+        m_lookupTextureDirty = false;
+    }
+}
+
+void VideoMaterial::uploadFrame(GstBuffer *frame)
+{
+    FrameLayout layout;
+    frameLayout(frame, &layout);
+
+    GstMapInfo info;
+    gst_buffer_map(frame, &info, GST_MAP_READ);
+
+    if (m_usePixelBuffers && initPixelBuffers(info.size)) {
+        const int index = m_pixelBufferIndex;
+        m_pixelBufferIndex = (m_pixelBufferIndex + 1) % Num_Pixel_Buffers;
+
+        // the texture transfer starts from the buffer just filled and
+        // runs on the GPU, while the next frames go into the other ones
+        fillPixelBuffer(index, info.data, info.size);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBufferIds[index]);
+        bindTextures(NULL, layout);
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
     } else {
-        glActiveTexture(GL_TEXTURE1);
-        glBindTexture(GL_TEXTURE_2D, m_textureIds[1]);
-        glActiveTexture(GL_TEXTURE2);
-        glBindTexture(GL_TEXTURE_2D, m_textureIds[2]);
-        glActiveTexture(GL_TEXTURE0); // Finish with 0 as default texture unit
-        glBindTexture(GL_TEXTURE_2D, m_textureIds[0]);
+        bindTextures(info.data, layout);
+    }
+
+    gst_buffer_unmap(frame, &info);
+}
+
+void VideoMaterial::frameLayout(GstBuffer *frame, FrameLayout *layout) const
+{
+    // the meta offsets are relative to the start of the buffer, just like
+    // the data of a gst_buffer_map() of the whole buffer
+    GstVideoMeta *meta = gst_buffer_get_video_meta(frame);
+
+    for (int p = 0; p < GST_VIDEO_MAX_PLANES; p++) {
+        if (meta && p < int(meta->n_planes)) {
+            layout->offset[p] = meta->offset[p];
+            layout->stride[p] = meta->stride[p];
+        } else {
+            layout->offset[p] = GST_VIDEO_INFO_PLANE_OFFSET(&m_videoInfo, p);
+            layout->stride[p] = GST_VIDEO_INFO_PLANE_STRIDE(&m_videoInfo, p);
+        }
+    }
+}
+
+void VideoMaterial::bindTextures(const quint8 *data, const FrameLayout &layout)
+{
+    // Finish with 0 as default texture unit
+    for (int i = m_textureCount - 1; i >= 0; i--) {
+        glActiveTexture(GL_TEXTURE0 + i);
+        bindTexture(i, data, layout);
     }
 }
 
-void VideoMaterial::bindTexture(int i, const quint8 *data)
+void VideoMaterial::bindTexture(int i, const quint8 *data, const FrameLayout &layout)
 {
+    const Texture &texture = m_textures[i];
+    const int stride = layout.stride[texture.plane];
+    const quint8 *pixels = data + layout.offset[texture.plane];
+
+    // the largest alignment the stride allows; GL then pads each row to
+    // exactly the stride whenever upstream only aligned the rows
+    int alignment = 8;
+    while (stride % alignment)
+        alignment /= 2;
+    const int rowBytes = texture.width * texture.bytesPerTexel;
+    const int paddedRowBytes = (rowBytes + alignment - 1) & ~(alignment - 1);
+
     glBindTexture(GL_TEXTURE_2D, m_textureIds[i]);
-    glTexImage2D(
-        GL_TEXTURE_2D,
-        0,
-        m_textureInternalFormat,
-        m_textureWidths[i],
-        m_textureHeights[i],
-        0,
-        m_textureFormat,
-        m_textureType,
-        data + m_textureOffsets[i]);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_CLAMP_TO_EDGE);
-    glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_CLAMP_TO_EDGE);
+    glPixelStorei(GL_UNPACK_ALIGNMENT, alignment);
+
+    if (stride == paddedRowBytes) {
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height,
+                        texture.format, texture.type, pixels);
+    } else if (m_hasUnpackRowLength && stride % texture.bytesPerTexel == 0) {
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, stride / texture.bytesPerTexel);
+        glTexSubImage2D(GL_TEXTURE_2D, 0, 0, 0, texture.width, texture.height,
+                        texture.format, texture.type, pixels);
+        glPixelStorei(GL_UNPACK_ROW_LENGTH, 0);
+    } else {
+        // ES2 has no GL_UNPACK_ROW_LENGTH
+        for (int y = 0; y < texture.height; y++) {
+            glTexSubImage2D(GL_TEXTURE_2D, 0, 0, y, texture.width, 1,
+                            texture.format, texture.type, pixels + y * stride);
+        }
+    }
+
+    glPixelStorei(GL_UNPACK_ALIGNMENT, 4);
+}
+
+static bool hasPixelBufferObjects(QOpenGLContext *context)
+{
+    if (context->isOpenGLES())
+        return context->format().majorVersion() >= 3;
+
+    return context->format().version() >= qMakePair(2, 1)
+        || context->hasExtension(QByteArrayLiteral("GL_ARB_pixel_buffer_object"));
+}
+
+bool VideoMaterial::initPixelBuffers(int size)
+{
+    if (!m_pixelBufferIds[0]) {
+        if (!hasPixelBufferObjects(QOpenGLContext::currentContext())) {
+            GST_WARNING("Pixel buffer objects are not supported by this "
+                        "OpenGL context, using synchronous uploads");
+            m_usePixelBuffers = false;
+            return false;
+        }
+        glGenBuffers(Num_Pixel_Buffers, m_pixelBufferIds);
+    }
+
+    if (size > m_pixelBufferSize) {
+        for (int i = 0; i < Num_Pixel_Buffers; i++) {
+            glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBufferIds[i]);
+            glBufferData(GL_PIXEL_UNPACK_BUFFER, size, NULL, GL_STREAM_DRAW);
+        }
+        glBindBuffer(GL_PIXEL_UNPACK_BUFFER, 0);
+        m_pixelBufferSize = size;
+    }
+
+    return true;
 }
 
+void VideoMaterial::fillPixelBuffer(int index, const quint8 *data, int size)
+{
+    QOpenGLContext *context = QOpenGLContext::currentContext();
+    glBindBuffer(GL_PIXEL_UNPACK_BUFFER, m_pixelBufferIds[index]);
+
+    // glMapBufferRange is only available from GL 3.0 / GLES 3.0; with an
+    // invalidated range the driver never has to wait for the GPU
+    void *dest = NULL;
+    if (context->isOpenGLES() || context->format().majorVersion() >= 3) {
+        dest = context->extraFunctions()->glMapBufferRange(
+            GL_PIXEL_UNPACK_BUFFER, 0, size,
+            GL_MAP_WRITE_BIT | GL_MAP_INVALIDATE_BUFFER_BIT);
+    }
+
+    if (dest) {
+        memcpy(dest, data, size);
+        context->extraFunctions()->glUnmapBuffer(GL_PIXEL_UNPACK_BUFFER);
+    } else {
+        glBufferSubData(GL_PIXEL_UNPACK_BUFFER, 0, size, data);
+    }
+}
@@ -20,6 +20,9 @@
 #define VIDEOMATERIAL_H
 
 #include "../utils/bufferformat.h"
+#include "../utils/renderstatistics.h"
+#include "../utils/colorlookuptable.h"
+#include "videoeffect.h"
 #include <QSize>
 #include <QMutex>
 #include <QMatrix4x4>
@@ -38,40 +41,115 @@ public:
 
     virtual int compare(const QSGMaterial *other) const;
 
-    void setCurrentFrame(GstBuffer *buffer);
+    // returns the generation of the frame that is current from now on
+    quint64 setCurrentFrame(GstBuffer *buffer);
     void updateColors(int brightness, int contrast, int hue, int saturation);
+    void setUsePixelBuffers(bool use);
+    void setStatistics(const RenderStatistics::Ptr & statistics);
+
+    // changes type(), so the node has to be marked dirty
+    VideoEffect::Type effect() const { return m_effect; }
+    void setEffect(VideoEffect::Type effect);
+
+    // applied after the colour matrix; changes type() when it comes or goes
+    const ColorLookupTable::Ptr & colorLookupTable() const { return m_colorLookupTable; }
+    void setColorLookupTable(const ColorLookupTable::Ptr & table);
 
     void bind();
 
+    // after the planes of the frame
+    static const int Lookup_Texture_Unit = 3;
+
 protected:
+    // how one plane of a frame is stored in a texture
+    enum TextureKind {
+        TextureNone,
+        TextureRgba,
+        TextureRgb,
+        TextureRgb565,
+        TextureOneChannel,  // GL_RED, or GL_LUMINANCE without texture_rg
+        TextureTwoChannel   // GL_RG, or GL_LUMINANCE_ALPHA without texture_rg
+    };
+
     VideoMaterial();
-    void initRgbTextureInfo(GLenum internalFormat, GLuint format,
-                            GLenum type, const QSize &size);
-    void initYuv420PTextureInfo(bool uvSwapped, const QSize &size);
+    void initTextureInfo(const GstVideoInfo &videoInfo, const TextureKind *planeKinds,
+                         GLint filter, bool textureRg);
     void init(GstVideoColorMatrix colorMatrixType);
 
 private:
-    void bindTexture(int i, const quint8 *data);
+    struct FormatInfo;
+    static const FormatInfo *formatInfo(GstVideoFormat format);
+
+    void allocateTextures();
+    // where the planes are in a mapped frame; from the GstVideoMeta when
+    // upstream attached one, from the caps otherwise
+    struct FrameLayout {
+        gsize offset[GST_VIDEO_MAX_PLANES];
+        gint stride[GST_VIDEO_MAX_PLANES];
+    };
+
+    void frameLayout(GstBuffer *frame, FrameLayout *layout) const;
+    void bindTexture(int i, const quint8 *data, const FrameLayout &layout);
+    void bindTextures(const quint8 *data, const FrameLayout &layout);
+    void bindColorLookupTable();
+    void uploadFrame(GstBuffer *frame);
+
+    bool initPixelBuffers(int size);
+    void fillPixelBuffer(int index, const quint8 *data, int size);
 
 
     GstBuffer *m_frame;
     QMutex m_frameMutex;
 
+    // bumped for every new m_frame; bind() only uploads when it differs
+    // from the generation that is already in the textures
+    quint64 m_frameGeneration;
+    quint64 m_uploadedGeneration;
+
+    struct Texture {
+        int plane;
+        int width;
+        int height;
+        int bytesPerTexel;
+        GLint internalFormat;
+        GLenum sizedFormat;
+        GLenum format;
+        GLenum type;
+    };
+
+    // one texture per plane, ordered by the first component stored in it,
+    // so that the shaders always see Y, U, V (or Y, UV) in that order
     static const int Num_Texture_IDs = 3;
     int m_textureCount;
     GLuint m_textureIds[Num_Texture_IDs];
-    int m_textureWidths[Num_Texture_IDs];
-    int m_textureHeights[Num_Texture_IDs];
-    int m_textureOffsets[Num_Texture_IDs];
-    QSize m_textureSize;
-
-    GLenum m_textureFormat;
-    GLuint m_textureInternalFormat;
-    GLenum m_textureType;
+    Texture m_textures[Num_Texture_IDs];
+    GLint m_textureFilter;
+    bool m_hasUnpackRowLength;
+
+    GstVideoInfo m_videoInfo;
+    int m_frameWidth;
+
+    // asynchronous uploads: the textures are fed from a pixel buffer
+    // object, so that the copy into it never waits for the GPU still
+    // reading the previous frames from the others
+    static const int Num_Pixel_Buffers = 3;
+    bool m_usePixelBuffers;
+    GLuint m_pixelBufferIds[Num_Pixel_Buffers];
+    int m_pixelBufferSize;
+    int m_pixelBufferIndex;
 
     QMatrix4x4 m_colorMatrix;
     GstVideoColorMatrix m_colorMatrixType;
 
+    // where the upload times are recorded, if anywhere
+    RenderStatistics::Ptr m_statistics;
+
+    VideoEffect::Type m_effect;
+
+    ColorLookupTable::Ptr m_colorLookupTable;
+    GLuint m_lookupTextureId;
+    bool m_lookupTextureDirty;
+
     friend class VideoMaterialShader;
 };
 
@@ -24,14 +24,43 @@
 VideoNode::VideoNode()
   : QSGGeometryNode()
   , m_validGeometry(false)
+  , m_videoMaterial(NULL)
+  , m_frameGeneration(0)
 {
     setFlags(OwnsGeometry | OwnsMaterial, true);
     setMaterialTypeSolidBlack();
 }
 
-void VideoNode::changeFormat(const BufferFormat & format)
+VideoNode::~VideoNode()
 {
-    setMaterial(VideoMaterial::create(format));
+    releaseMaterial();
+}
+
+void VideoNode::releaseMaterial()
+{
+    if (m_videoMaterial) {
+        m_materials->release(m_videoMaterial);
+        m_videoMaterial = NULL;
+        m_materials.clear();
+        m_format = BufferFormat();
+    }
+}
+
+void VideoNode::changeFormat(const BufferFormat & format,
+                             const SharedVideoMaterials::Ptr & materials)
+{
+    VideoMaterial *material = materials->acquire(format);
+
+    //the solid black material is ours, the video ones are shared
+    setFlag(OwnsMaterial, !m_videoMaterial);
+    setMaterial(material);
+    setFlag(OwnsMaterial, false);
+    releaseMaterial();
+
+    m_videoMaterial = material;
+    m_materials = materials;
+    m_format = format;
+    m_frameGeneration = 0;
     m_materialType = MaterialTypeVideo;
     m_validGeometry = false;
 }
@@ -40,7 +69,12 @@ void VideoNode::setMaterialTypeSolidBlack()
 {
     QSGFlatColorMaterial *m = new QSGFlatColorMaterial;
     m->setColor(Qt::black);
+
+    setFlag(OwnsMaterial, !m_videoMaterial);
     setMaterial(m);
+    setFlag(OwnsMaterial, true);
+    releaseMaterial();
+
     m_materialType = MaterialTypeSolidBlack;
     m_validGeometry = false;
 }
@@ -48,14 +82,40 @@ void VideoNode::setMaterialTypeSolidBlack()
 void VideoNode::setCurrentFrame(GstBuffer* buffer)
 {
     Q_ASSERT (m_materialType == MaterialTypeVideo);
-    static_cast<VideoMaterial*>(material())->setCurrentFrame(buffer);
-    markDirty(DirtyMaterial);
+
+    //another node sharing the material may have set this frame already,
+    //but this one has not been redrawn with it yet
+    const quint64 generation = m_videoMaterial->setCurrentFrame(buffer);
+    if (generation != m_frameGeneration) {
+        m_frameGeneration = generation;
+        markDirty(DirtyMaterial);
+    }
 }
 
 void VideoNode::updateColors(int brightness, int contrast, int hue, int saturation)
 {
     Q_ASSERT (m_materialType == MaterialTypeVideo);
-    static_cast<VideoMaterial*>(material())->updateColors(brightness, contrast, hue, saturation);
+    m_videoMaterial->updateColors(brightness, contrast, hue, saturation);
+    markDirty(DirtyMaterial);
+}
+
+void VideoNode::setUsePixelBuffers(bool use)
+{
+    Q_ASSERT (m_materialType == MaterialTypeVideo);
+    m_videoMaterial->setUsePixelBuffers(use);
+}
+
+void VideoNode::setEffect(VideoEffect::Type effect)
+{
+    Q_ASSERT (m_materialType == MaterialTypeVideo);
+    m_videoMaterial->setEffect(effect);
+    markDirty(DirtyMaterial);
+}
+
+void VideoNode::setColorLookupTable(const ColorLookupTable::Ptr & table)
+{
+    Q_ASSERT (m_materialType == MaterialTypeVideo);
+    m_videoMaterial->setColorLookupTable(table);
     markDirty(DirtyMaterial);
 }
 
@@ -73,7 +133,7 @@ static inline void setTex(QSGGeometry::TexturedPoint2D *v, const QPointF &p)
     v->ty = p.y();
 }
 
-void VideoNode::updateGeometry(const PaintAreas & areas)
+void VideoNode::updateGeometry(const PaintAreas & areas, const QTransform & textureTransform)
 {
     QSGGeometry *g = geometry();
 
@@ -90,10 +150,10 @@ void VideoNode::updateGeometry(const PaintAreas & areas)
         setGeom(v + 3, areas.videoArea.bottomRight());
 
         // and then texture coordinates
-        setTex(v + 0, areas.sourceRect.topLeft());
-        setTex(v + 1, areas.sourceRect.bottomLeft());
-        setTex(v + 2, areas.sourceRect.topRight());
-        setTex(v + 3, areas.sourceRect.bottomRight());
+        setTex(v + 0, textureTransform.map(areas.sourceRect.topLeft()));
+        setTex(v + 1, textureTransform.map(areas.sourceRect.bottomLeft()));
+        setTex(v + 2, textureTransform.map(areas.sourceRect.topRight()));
+        setTex(v + 3, textureTransform.map(areas.sourceRect.bottomRight()));
     } else {
         if (!m_validGeometry)
             g = new QSGGeometry(QSGGeometry::defaultAttributes_Point2D(), 4);
@@ -20,13 +20,17 @@
 #define VIDEONODE_H
 
 #include "../utils/bufferformat.h"
+#include "sharedvideomaterials.h"
+#include "videoeffect.h"
 
 #include <QtQuick/QSGGeometryNode>
+#include <QTransform>
 
 class VideoNode : public QSGGeometryNode
 {
 public:
     VideoNode();
+    ~VideoNode();
 
     enum MaterialType {
         MaterialTypeVideo,
@@ -35,17 +39,53 @@ public:
 
     MaterialType materialType() const { return m_materialType; }
 
-    void changeFormat(const BufferFormat &format);
+    // the format of the video material, if any
+    const BufferFormat & format() const { return m_format; }
+
+    // what the delegate last applied to this node; each item of a
+    // surface has its own node, and thus its own geometry
+    struct State
+    {
+        State() : colorsVersion(0), geometryVersion(0), pixelBuffersVersion(0), effectVersion(0),
+                  colorFilterVersion(0) {}
+
+        PaintAreas areas;
+        QRect cropRect;
+        quint32 colorsVersion;
+        quint32 geometryVersion;
+        quint32 pixelBuffersVersion;
+        quint32 effectVersion;
+        quint32 colorFilterVersion;
+    };
+    State & state() { return m_state; }
+
+    // switches to the material of the sink for this format, which
+    // other nodes in the same window may be drawing with already
+    void changeFormat(const BufferFormat &format, const SharedVideoMaterials::Ptr &materials);
     void setMaterialTypeSolidBlack();
 
     void setCurrentFrame(GstBuffer *buffer);
     void updateColors(int brightness, int contrast, int hue, int saturation);
+    void setUsePixelBuffers(bool use);
+    void setEffect(VideoEffect::Type effect);
+    void setColorLookupTable(const ColorLookupTable::Ptr & table);
 
-    void updateGeometry(const PaintAreas & areas);
+    // textureTransform maps areas.sourceRect to texture coordinates,
+    // which is how the picture is cropped, rotated and mirrored
+    void updateGeometry(const PaintAreas & areas,
+                        const QTransform & textureTransform = QTransform());
 
 private:
+    void releaseMaterial();
+
     MaterialType m_materialType;
     bool m_validGeometry;
+    State m_state;
+
+    BufferFormat m_format;
+    SharedVideoMaterials::Ptr m_materials;
+    VideoMaterial *m_videoMaterial; // not owned, released to m_materials
+    quint64 m_frameGeneration;
 };
 
 #endif // VIDEONODE_H
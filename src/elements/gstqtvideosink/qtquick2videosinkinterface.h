@@ -0,0 +1,51 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef __GST_QT_QUICK2_VIDEO_SINK_INTERFACE_H__
+#define __GST_QT_QUICK2_VIDEO_SINK_INTERFACE_H__
+
+#include <gst/gst.h>
+
+/* Functions of qtquick2videosink that the items showing it call directly,
+ * without going through GObject signals. Read the table once from the
+ * sink's "update-node-interface" property; it stays valid as long as the
+ * plugin is loaded.
+ *
+ * The table only ever grows at the end, and version tells how much of it
+ * there is. Callers check that it is at least the version that introduced
+ * the fields they use, and fall back to the signals otherwise. Only plain
+ * C types are used, so that the application and the plugin do not have to
+ * agree on anything else. */
+
+#define GST_QT_QUICK2_VIDEO_SINK_INTERFACE_VERSION 2
+
+typedef struct _GstQtQuick2VideoSinkInterface GstQtQuick2VideoSinkInterface;
+
+struct _GstQtQuick2VideoSinkInterface
+{
+    guint version;
+
+    /* version 1; the same as the "update-node" signal, to be called from
+     * the render thread while it syncs with the item */
+    gpointer (*update_node)(GstElement *sink, gpointer node,
+                            gdouble x, gdouble y, gdouble width, gdouble height);
+
+    /* version 2; the same, also given the QQuickWindow of the item, without
+     * which nothing is drawn by the software scene graph */
+    gpointer (*update_node_in_window)(GstElement *sink, gpointer node, gpointer window,
+                                      gdouble x, gdouble y, gdouble width, gdouble height);
+};
+
+#endif /* __GST_QT_QUICK2_VIDEO_SINK_INTERFACE_H__ */
@@ -16,6 +16,7 @@
 */
 #include "bufferformat.h"
 #include <QByteArray>
+#include <gst/video/gstvideometa.h>
 
 BufferFormat BufferFormat::fromCaps(GstCaps *caps)
 {
@@ -48,6 +49,42 @@ int BufferFormat::bytesPerLine(int component) const
     return GST_VIDEO_INFO_PLANE_STRIDE(&(d->videoInfo), component);
 }
 
+BufferFormat BufferFormat::withFrameSize(const QSize & size) const
+{
+    GstCaps *caps = gst_video_info_to_caps(&(d->videoInfo));
+    gst_caps_set_simple(caps, "width", G_TYPE_INT, size.width(),
+                        "height", G_TYPE_INT, size.height(), NULL);
+    BufferFormat result = fromCaps(caps);
+    gst_caps_unref(caps);
+
+    result.d->visibleRect = visibleRect();
+    return result;
+}
+
+QRect BufferFormat::visibleRect(GstBuffer *buffer) const
+{
+    GstVideoCropMeta *meta = buffer ? gst_buffer_get_video_crop_meta(buffer) : NULL;
+    if (meta && meta->width > 0 && meta->height > 0)
+        return QRect(meta->x, meta->y, meta->width, meta->height);
+
+    if (!d->visibleRect.isNull())
+        return d->visibleRect;
+
+    return QRect(QPoint(), frameSize());
+}
+
+QTransform BufferFormat::cropTransform(const QRect & visible) const
+{
+    const QSize size = frameSize();
+    if (size.isEmpty())
+        return QTransform();
+
+    return QTransform(qreal(visible.width()) / size.width(), 0,
+                      0, qreal(visible.height()) / size.height(),
+                      qreal(visible.x()) / size.width(),
+                      qreal(visible.y()) / size.height());
+}
+
 bool operator==(BufferFormat a, BufferFormat b)
 {
     return a.d == b.d;
@@ -19,6 +19,8 @@
 
 #include "utils.h"
 #include <QSharedData>
+#include <QRect>
+#include <QTransform>
 #include <gst/video/video.h>
 
 /**
@@ -48,6 +50,18 @@ public:
 
     int bytesPerLine(int component = 0) const;
 
+    // the same format for frames laid out in memory with another size, as
+    // a GstVideoMeta may say; what the caps said is still what is shown
+    BufferFormat withFrameSize(const QSize & size) const;
+
+    // the part of the frame to show: the buffer's crop meta if it has one,
+    // the size in the caps otherwise
+    QRect visibleRect(GstBuffer *buffer = NULL) const;
+
+    // maps the visible part, normalized to 0..1, to texture coordinates
+    // of the whole frame
+    QTransform cropTransform(const QRect & visible) const;
+
 private:
     friend bool operator==(BufferFormat a, BufferFormat b);
     friend bool operator!=(BufferFormat a, BufferFormat b);
@@ -58,6 +72,7 @@ private:
         { gst_video_info_init(&videoInfo); }
 
         GstVideoInfo videoInfo;
+        QRect visibleRect; // null for the whole frame
     };
     QSharedDataPointer<Data> d;
 };
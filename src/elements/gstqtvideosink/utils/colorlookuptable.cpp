@@ -0,0 +1,140 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "colorlookuptable.h"
+
+#include <gst/video/video.h>
+#include <cstring>
+
+ColorLookupTable::ColorLookupTable(const QByteArray & description, int size)
+    : m_description(description)
+    , m_size(size)
+{
+}
+
+static GstBuffer *latticeBuffer(int size)
+{
+    const int width = size * size;
+    GstBuffer *buffer = gst_buffer_new_allocate(NULL, width * size * 4, NULL);
+
+    GstMapInfo info;
+    gst_buffer_map(buffer, &info, GST_MAP_WRITE);
+    for (int g = 0; g < size; g++) {
+        quint8 *texel = info.data + g * width * 4;
+        for (int b = 0; b < size; b++) {
+            for (int r = 0; r < size; r++) {
+                texel[0] = (r * 255 + (size - 1) / 2) / (size - 1);
+                texel[1] = (g * 255 + (size - 1) / 2) / (size - 1);
+                texel[2] = (b * 255 + (size - 1) / 2) / (size - 1);
+                texel[3] = 255;
+                texel += 4;
+            }
+        }
+    }
+    gst_buffer_unmap(buffer, &info);
+
+    return buffer;
+}
+
+/* The lattice goes through the elements as a single RGBA frame, which
+ * fakesink keeps as its preroll sample. This costs a few milliseconds
+ * once, instead of running the elements on every frame. */
+ColorLookupTable::Ptr ColorLookupTable::bake(const QByteArray & description, int size,
+                                             GError **error)
+{
+    g_return_val_if_fail(size >= 2, Ptr());
+
+    const QByteArray launch = "appsrc name=src format=time ! videoconvert ! " + description
+            + " ! videoconvert ! video/x-raw,format=RGBA"
+            + " ! fakesink name=sink enable-last-sample=true sync=false";
+
+    GError *parseError = NULL;
+    GstElement *pipeline = gst_parse_launch(launch.constData(), &parseError);
+    if (parseError) {
+        g_propagate_error(error, parseError);
+        if (pipeline)
+            gst_object_unref(pipeline);
+        return Ptr();
+    }
+
+    QSharedPointer<ColorLookupTable> table(new ColorLookupTable(description, size));
+
+    GstElement *src = gst_bin_get_by_name(GST_BIN(pipeline), "src");
+    GstElement *sink = gst_bin_get_by_name(GST_BIN(pipeline), "sink");
+
+    GstCaps *caps = gst_caps_new_simple("video/x-raw",
+            "format", G_TYPE_STRING, "RGBA",
+            "width", G_TYPE_INT, table->width(),
+            "height", G_TYPE_INT, table->height(),
+            "framerate", GST_TYPE_FRACTION, 0, 1,
+            NULL);
+    g_object_set(src, "caps", caps, NULL);
+    gst_caps_unref(caps);
+
+    GstFlowReturn flow;
+    GstBuffer *lattice = latticeBuffer(size);
+    g_signal_emit_by_name(src, "push-buffer", lattice, &flow);
+    g_signal_emit_by_name(src, "end-of-stream", &flow);
+    gst_buffer_unref(lattice);
+
+    gst_element_set_state(pipeline, GST_STATE_PAUSED);
+    GstState state = GST_STATE_NULL;
+    gst_element_get_state(pipeline, &state, NULL, 10 * GST_SECOND);
+
+    GstSample *sample = NULL;
+    if (state == GST_STATE_PAUSED)
+        g_object_get(sink, "last-sample", &sample, NULL);
+
+    GstVideoInfo videoInfo;
+    GstMapInfo info;
+    if (sample && gst_video_info_from_caps(&videoInfo, gst_sample_get_caps(sample))
+            && GST_VIDEO_INFO_WIDTH(&videoInfo) == table->width()
+            && GST_VIDEO_INFO_HEIGHT(&videoInfo) == table->height()
+            && gst_buffer_map(gst_sample_get_buffer(sample), &info, GST_MAP_READ)) {
+        const int rowSize = table->width() * 4;
+        table->m_data.resize(rowSize * table->height());
+        for (int y = 0; y < table->height(); y++) {
+            std::memcpy(table->m_data.data() + y * rowSize,
+                        info.data + GST_VIDEO_INFO_PLANE_OFFSET(&videoInfo, 0)
+                            + y * GST_VIDEO_INFO_PLANE_STRIDE(&videoInfo, 0),
+                        rowSize);
+        }
+        gst_buffer_unmap(gst_sample_get_buffer(sample), &info);
+    } else {
+        //the elements posted the reason, if anything
+        GstBus *bus = gst_element_get_bus(pipeline);
+        GstMessage *message = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+        if (message) {
+            GError *messageError = NULL;
+            gst_message_parse_error(message, &messageError, NULL);
+            g_propagate_error(error, messageError);
+            gst_message_unref(message);
+        } else {
+            g_set_error(error, GST_STREAM_ERROR, GST_STREAM_ERROR_FAILED,
+                        "\"%s\" did not turn the lattice into a frame", description.constData());
+        }
+        gst_object_unref(bus);
+        table.clear();
+    }
+
+    if (sample)
+        gst_sample_unref(sample);
+    gst_object_unref(sink);
+    gst_object_unref(src);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+
+    return table;
+}
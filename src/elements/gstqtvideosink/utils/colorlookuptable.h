@@ -0,0 +1,62 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef COLORLOOKUPTABLE_H
+#define COLORLOOKUPTABLE_H
+
+#include <gst/gst.h>
+#include <QByteArray>
+#include <QSharedPointer>
+
+/**
+ * A colour-only filter chain, baked into a table that the shaders look
+ * the output colour up in.
+ *
+ * The table samples the RGB cube on a lattice of size() points per side.
+ * It is stored the way GLES 2 can hold it, as a 2D RGBA image of
+ * size() slices laid side by side: red grows to the right within a
+ * slice, green downwards and blue from one slice to the next. Colours in
+ * between are interpolated, so the filter has to be smooth for the
+ * result to match it.
+ */
+class ColorLookupTable
+{
+public:
+    typedef QSharedPointer<const ColorLookupTable> Ptr;
+
+    static const int Default_Size = 33;
+
+    // runs the lattice through the elements in description, e.g.
+    // "videobalance saturation=0"; returns NULL and sets error on failure
+    static Ptr bake(const QByteArray & description, int size = Default_Size,
+                    GError **error = NULL);
+
+    const QByteArray & description() const { return m_description; }
+    int size() const { return m_size; }
+
+    // size() * size() wide, size() high, 4 bytes per texel, no padding
+    int width() const { return m_size * m_size; }
+    int height() const { return m_size; }
+    const QByteArray & data() const { return m_data; }
+
+private:
+    ColorLookupTable(const QByteArray & description, int size);
+
+    const QByteArray m_description;
+    const int m_size;
+    QByteArray m_data;
+};
+
+#endif // COLORLOOKUPTABLE_H
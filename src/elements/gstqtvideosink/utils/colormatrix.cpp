@@ -0,0 +1,98 @@
+/*
+    Copyright (C) 2011-2013 Collabora Ltd. <info@collabora.com>
+    Copyright (C) 2013 Digia Plc and/or its subsidiary(-ies).
+    Copyright (C) 2013 basysKom GmbH <info@basyskom.com>
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+
+#include "colormatrix.h"
+
+#include <qmath.h>
+
+QMatrix4x4 colorMatrix(int brightness, int contrast, int hue, int saturation,
+                       GstVideoColorMatrix colorMatrixType)
+{
+    QMatrix4x4 matrix;
+
+    const qreal b = brightness / 200.0;
+    const qreal c = contrast / 100.0 + 1.0;
+    const qreal h = hue / 100.0;
+    const qreal s = saturation / 100.0 + 1.0;
+
+    const qreal cosH = qCos(M_PI * h);
+    const qreal sinH = qSin(M_PI * h);
+
+    const qreal h11 =  0.787 * cosH - 0.213 * sinH + 0.213;
+    const qreal h21 = -0.213 * cosH + 0.143 * sinH + 0.213;
+    const qreal h31 = -0.213 * cosH - 0.787 * sinH + 0.213;
+
+    const qreal h12 = -0.715 * cosH - 0.715 * sinH + 0.715;
+    const qreal h22 =  0.285 * cosH + 0.140 * sinH + 0.715;
+    const qreal h32 = -0.715 * cosH + 0.715 * sinH + 0.715;
+
+    const qreal h13 = -0.072 * cosH + 0.928 * sinH + 0.072;
+    const qreal h23 = -0.072 * cosH - 0.283 * sinH + 0.072;
+    const qreal h33 =  0.928 * cosH + 0.072 * sinH + 0.072;
+
+    const qreal sr = (1.0 - s) * 0.3086;
+    const qreal sg = (1.0 - s) * 0.6094;
+    const qreal sb = (1.0 - s) * 0.0820;
+
+    const qreal sr_s = sr + s;
+    const qreal sg_s = sg + s;
+    const qreal sb_s = sr + s;
+
+    const float m4 = (s + sr + sg + sb) * (0.5 - 0.5 * c + b);
+
+    matrix(0, 0) = c * (sr_s * h11 + sg * h21 + sb * h31);
+    matrix(0, 1) = c * (sr_s * h12 + sg * h22 + sb * h32);
+    matrix(0, 2) = c * (sr_s * h13 + sg * h23 + sb * h33);
+    matrix(0, 3) = m4;
+
+    matrix(1, 0) = c * (sr * h11 + sg_s * h21 + sb * h31);
+    matrix(1, 1) = c * (sr * h12 + sg_s * h22 + sb * h32);
+    matrix(1, 2) = c * (sr * h13 + sg_s * h23 + sb * h33);
+    matrix(1, 3) = m4;
+
+    matrix(2, 0) = c * (sr * h11 + sg * h21 + sb_s * h31);
+    matrix(2, 1) = c * (sr * h12 + sg * h22 + sb_s * h32);
+    matrix(2, 2) = c * (sr * h13 + sg * h23 + sb_s * h33);
+    matrix(2, 3) = m4;
+
+    matrix(3, 0) = 0.0;
+    matrix(3, 1) = 0.0;
+    matrix(3, 2) = 0.0;
+    matrix(3, 3) = 1.0;
+
+    switch (colorMatrixType) {
+    case GST_VIDEO_COLOR_MATRIX_BT709:
+        matrix *= QMatrix4x4(
+                    1.164,  0.000,  1.793, -0.5727,
+                    1.164, -0.534, -0.213,  0.3007,
+                    1.164,  2.115,  0.000, -1.1302,
+                    0.0,    0.000,  0.000,  1.0000);
+        break;
+    case GST_VIDEO_COLOR_MATRIX_BT601:
+        matrix *= QMatrix4x4(
+                    1.164,  0.000,  1.596, -0.8708,
+                    1.164, -0.392, -0.813,  0.5296,
+                    1.164,  2.017,  0.000, -1.081,
+                    0.0,    0.000,  0.000,  1.0000);
+        break;
+    default:
+        break;
+    }
+
+    return matrix;
+}
@@ -0,0 +1,31 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef COLORMATRIX_H
+#define COLORMATRIX_H
+
+#include <gst/video/video.h>
+#include <QMatrix4x4>
+
+/**
+ * The matrix that turns the components of a pixel, normalized to 0..1
+ * and followed by a 1, into RGB with the given colour balance applied.
+ * The balance values are those of the GstColorBalance interface; the
+ * YUV conversion is only done for the BT.601 and BT.709 matrices.
+ */
+QMatrix4x4 colorMatrix(int brightness, int contrast, int hue, int saturation,
+                       GstVideoColorMatrix colorMatrixType);
+
+#endif // COLORMATRIX_H
@@ -0,0 +1,64 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "decodetimemeta.h"
+
+GType gst_qt_decode_time_meta_api_get_type()
+{
+    static volatile gsize type = 0;
+    // no tags: it stays true whatever is done to the pixels afterwards
+    static const gchar *tags[] = { NULL };
+
+    if (g_once_init_enter(&type)) {
+        GType api = gst_meta_api_type_register("GstQtDecodeTimeMetaAPI", tags);
+        g_once_init_leave(&type, (gsize) api);
+    }
+    return (GType) type;
+}
+
+static gboolean
+gst_qt_decode_time_meta_init(GstMeta *meta, gpointer, GstBuffer *)
+{
+    reinterpret_cast<GstQtDecodeTimeMeta*>(meta)->decode_time = GST_CLOCK_TIME_NONE;
+    return TRUE;
+}
+
+static gboolean
+gst_qt_decode_time_meta_transform(GstBuffer *dest, GstMeta *meta, GstBuffer *, GQuark, gpointer)
+{
+    gst_buffer_add_qt_decode_time_meta(dest, reinterpret_cast<GstQtDecodeTimeMeta*>(meta)->decode_time);
+    return TRUE;
+}
+
+const GstMetaInfo *gst_qt_decode_time_meta_get_info()
+{
+    static const GstMetaInfo *info = NULL;
+
+    if (g_once_init_enter(&info)) {
+        const GstMetaInfo *meta = gst_meta_register(GST_QT_DECODE_TIME_META_API_TYPE,
+                "GstQtDecodeTimeMeta", sizeof(GstQtDecodeTimeMeta),
+                gst_qt_decode_time_meta_init, NULL, gst_qt_decode_time_meta_transform);
+        g_once_init_leave(&info, meta);
+    }
+    return info;
+}
+
+GstQtDecodeTimeMeta *gst_buffer_add_qt_decode_time_meta(GstBuffer *buffer, GstClockTime decode_time)
+{
+    GstQtDecodeTimeMeta *meta = reinterpret_cast<GstQtDecodeTimeMeta*>(
+            gst_buffer_add_meta(buffer, gst_qt_decode_time_meta_get_info(), NULL));
+    meta->decode_time = decode_time;
+    return meta;
+}
@@ -0,0 +1,41 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef DECODETIMEMETA_H
+#define DECODETIMEMETA_H
+
+#include <gst/gst.h>
+
+/**
+ * How long a frame took to decode, attached to it by qtjpegdec so that
+ * the sink can count it in its statistics.
+ */
+struct GstQtDecodeTimeMeta
+{
+    GstMeta meta;
+    GstClockTime decode_time;
+};
+
+GType gst_qt_decode_time_meta_api_get_type();
+#define GST_QT_DECODE_TIME_META_API_TYPE (gst_qt_decode_time_meta_api_get_type())
+
+const GstMetaInfo *gst_qt_decode_time_meta_get_info();
+
+GstQtDecodeTimeMeta *gst_buffer_add_qt_decode_time_meta(GstBuffer *buffer, GstClockTime decode_time);
+
+#define gst_buffer_get_qt_decode_time_meta(buffer) \
+    (reinterpret_cast<GstQtDecodeTimeMeta*>(gst_buffer_get_meta((buffer), GST_QT_DECODE_TIME_META_API_TYPE)))
+
+#endif // DECODETIMEMETA_H
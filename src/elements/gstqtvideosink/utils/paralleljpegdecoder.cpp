@@ -0,0 +1,115 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "paralleljpegdecoder.h"
+
+#include <QElapsedTimer>
+#include <QRunnable>
+#include <QThread>
+
+class ParallelJpegDecoder::Task : public QRunnable
+{
+public:
+    Task(ParallelJpegDecoder *decoder, Job *job) : m_decoder(decoder), m_job(job) {}
+
+    void run() override
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        QImage image;
+        GstMapInfo info;
+        if (gst_buffer_map(m_job->frame.buffer, &info, GST_MAP_READ)) {
+            image.loadFromData(info.data, info.size, "JPEG");
+            gst_buffer_unmap(m_job->frame.buffer, &info);
+        }
+
+        // greyscale JPEGs come out as Grayscale8
+        if (!image.isNull() && image.format() != QImage::Format_RGB32)
+            image = image.convertToFormat(QImage::Format_RGB32);
+
+        m_decoder->finish(m_job, image, timer.nsecsElapsed());
+    }
+
+private:
+    ParallelJpegDecoder * const m_decoder;
+    Job * const m_job;
+};
+
+ParallelJpegDecoder::ParallelJpegDecoder(int threads)
+{
+    m_pool.setMaxThreadCount(threads > 0 ? threads : QThread::idealThreadCount());
+    // cameras send frames all the time, there is no point in letting the
+    // threads go between them
+    m_pool.setExpiryTimeout(-1);
+}
+
+ParallelJpegDecoder::~ParallelJpegDecoder()
+{
+    flush();
+}
+
+int ParallelJpegDecoder::pending() const
+{
+    QMutexLocker l(&m_mutex);
+    return m_jobs.size();
+}
+
+void ParallelJpegDecoder::push(GstBuffer *buffer)
+{
+    Job *job = new Job;
+    job->frame.buffer = gst_buffer_ref(buffer);
+    job->done = false;
+
+    {
+        QMutexLocker l(&m_mutex);
+        m_jobs.enqueue(job);
+    }
+    m_pool.start(new Task(this, job));
+}
+
+bool ParallelJpegDecoder::take(Frame *frame, bool wait)
+{
+    QMutexLocker l(&m_mutex);
+    if (m_jobs.isEmpty())
+        return false;
+
+    while (!m_jobs.head()->done) {
+        if (!wait)
+            return false;
+        m_done.wait(&m_mutex);
+    }
+
+    Job *job = m_jobs.dequeue();
+    *frame = job->frame;
+    delete job;
+    return true;
+}
+
+void ParallelJpegDecoder::flush()
+{
+    Frame frame;
+    while (take(&frame, true))
+        gst_buffer_unref(frame.buffer);
+}
+
+void ParallelJpegDecoder::finish(Job *job, const QImage &image, GstClockTime decodeTime)
+{
+    QMutexLocker l(&m_mutex);
+    job->frame.image = image;
+    job->frame.decodeTime = decodeTime;
+    job->done = true;
+    m_done.wakeAll();
+}
@@ -0,0 +1,86 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef PARALLELJPEGDECODER_H
+#define PARALLELJPEGDECODER_H
+
+#include <gst/gst.h>
+
+#include <QImage>
+#include <QMutex>
+#include <QQueue>
+#include <QThreadPool>
+#include <QWaitCondition>
+
+/**
+ * Decodes JPEG frames on several threads at once, one frame per thread,
+ * and hands them back in the order they came in.
+ *
+ * A single frame cannot be split up, but a camera sends the next one
+ * long before the previous is decoded, so with N threads each frame may
+ * take up to N frame intervals. That much latency is added to the
+ * stream.
+ */
+class ParallelJpegDecoder
+{
+public:
+    struct Frame
+    {
+        Frame() : buffer(NULL), decodeTime(0) {}
+
+        GstBuffer *buffer;     // the JPEG, to be unreffed by the caller
+        QImage image;          // RGB32, null if the JPEG was broken
+        GstClockTime decodeTime;
+    };
+
+    // threads as 0 means one per core
+    explicit ParallelJpegDecoder(int threads = 0);
+    ~ParallelJpegDecoder();
+
+    int threads() const { return m_pool.maxThreadCount(); }
+
+    // frames queued and not taken yet; once that reaches threads(), the
+    // oldest has to be taken before pushing another
+    int pending() const;
+
+    // queues a frame for decoding; takes a reference to the buffer
+    void push(GstBuffer *buffer);
+
+    // the oldest frame, if it is decoded. With wait, blocks until it is,
+    // unless there are no frames at all
+    bool take(Frame *frame, bool wait);
+
+    // waits for the frames being decoded and drops them all
+    void flush();
+
+private:
+    Q_DISABLE_COPY(ParallelJpegDecoder)
+
+    class Task;
+    struct Job
+    {
+        Frame frame;
+        bool done;
+    };
+
+    void finish(Job *job, const QImage &image, GstClockTime decodeTime);
+
+    QThreadPool m_pool;
+    mutable QMutex m_mutex;
+    QWaitCondition m_done;
+    QQueue<Job*> m_jobs;
+};
+
+#endif // PARALLELJPEGDECODER_H
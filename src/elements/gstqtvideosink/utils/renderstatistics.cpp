@@ -0,0 +1,94 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#include "renderstatistics.h"
+
+#include <algorithm>
+
+RenderStatistics::RenderStatistics()
+    : m_framesReceived(0)
+    , m_framesRendered(0)
+    , m_framesReplaced(0)
+{
+}
+
+void RenderStatistics::frameRendered(qint64 latencyNs)
+{
+    m_framesRendered.ref();
+    if (latencyNs < 0)
+        return;
+
+    QMutexLocker l(&m_samplesMutex);
+    m_latencies.add(latencyNs);
+}
+
+void RenderStatistics::frameUploaded(qint64 uploadNs)
+{
+    QMutexLocker l(&m_samplesMutex);
+    m_uploadTimes.add(uploadNs);
+}
+
+void RenderStatistics::frameDecoded(qint64 decodeNs)
+{
+    QMutexLocker l(&m_samplesMutex);
+    m_decodeTimes.add(decodeNs);
+}
+
+RenderStatistics::Timings RenderStatistics::uploadTime() const
+{
+    QMutexLocker l(&m_samplesMutex);
+    return m_uploadTimes.timings();
+}
+
+RenderStatistics::Timings RenderStatistics::latency() const
+{
+    QMutexLocker l(&m_samplesMutex);
+    return m_latencies.timings();
+}
+
+RenderStatistics::Timings RenderStatistics::decodeTime() const
+{
+    QMutexLocker l(&m_samplesMutex);
+    return m_decodeTimes.timings();
+}
+
+void RenderStatistics::Samples::add(qint64 value)
+{
+    values[next] = value;
+    next = (next + 1) % Num_Samples;
+    count = qMin(count + 1, Num_Samples);
+}
+
+RenderStatistics::Timings RenderStatistics::Samples::timings() const
+{
+    Timings result;
+    if (!count)
+        return result;
+
+    qint64 sorted[Num_Samples];
+    std::copy(values, values + count, sorted);
+
+    qint64 sum = 0;
+    for (int i = 0; i < count; i++)
+        sum += sorted[i];
+
+    // the sample that 99% of the others do not exceed
+    const int p99 = (count * 99 + 99) / 100 - 1;
+    std::nth_element(sorted, sorted + p99, sorted + count);
+
+    result.average = sum / 1000.0 / count;
+    result.p99 = sorted[p99] / 1000.0;
+    return result;
+}
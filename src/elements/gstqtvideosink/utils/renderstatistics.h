@@ -0,0 +1,88 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef RENDERSTATISTICS_H
+#define RENDERSTATISTICS_H
+
+#include <QAtomicInteger>
+#include <QMutex>
+#include <QSharedPointer>
+
+/**
+ * Counters and timings of one sink, fed from the streaming thread and
+ * the render thread and read back through the sink's properties.
+ *
+ * Shared between the delegate and the materials it creates, since the
+ * scene graph may destroy a material after the sink is gone.
+ */
+class RenderStatistics
+{
+public:
+    typedef QSharedPointer<RenderStatistics> Ptr;
+
+    struct Timings
+    {
+        Timings() : average(0), p99(0) {}
+        double average;
+        double p99;
+    };
+
+    RenderStatistics();
+
+    // streaming thread
+    void frameReceived() { m_framesReceived.ref(); }
+    void frameReplaced() { m_framesReplaced.ref(); }
+
+    // streaming thread, for frames that say how long they took to decode
+    void frameDecoded(qint64 decodeNs);
+
+    // render thread; a negative latency means it is unknown
+    void frameRendered(qint64 latencyNs);
+    void frameUploaded(qint64 uploadNs);
+
+    quint64 framesReceived() const { return m_framesReceived.load(); }
+    quint64 framesRendered() const { return m_framesRendered.load(); }
+    quint64 framesReplaced() const { return m_framesReplaced.load(); }
+
+    // in microseconds, over the last Num_Samples frames
+    Timings uploadTime() const;
+    Timings latency() const;
+    Timings decodeTime() const;
+
+private:
+    static const int Num_Samples = 256;
+
+    struct Samples
+    {
+        Samples() : count(0), next(0) {}
+        void add(qint64 value);
+        Timings timings() const;
+
+        qint64 values[Num_Samples];
+        int count;
+        int next;
+    };
+
+    QAtomicInteger<quint64> m_framesReceived;
+    QAtomicInteger<quint64> m_framesRendered;
+    QAtomicInteger<quint64> m_framesReplaced;
+
+    mutable QMutex m_samplesMutex;
+    Samples m_uploadTimes;
+    Samples m_latencies;
+    Samples m_decodeTimes;
+};
+
+#endif // RENDERSTATISTICS_H
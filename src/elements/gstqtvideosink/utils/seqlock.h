@@ -0,0 +1,142 @@
+/*
+    Copyright (C) 2026 Kamoso developers
+
+    This library is free software; you can redistribute it and/or modify
+    it under the terms of the GNU Lesser General Public License version 2.1
+    as published by the Free Software Foundation.
+
+    This program is distributed in the hope that it will be useful,
+    but WITHOUT ANY WARRANTY; without even the implied warranty of
+    MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+    GNU Lesser General Public License for more details.
+
+    You should have received a copy of the GNU Lesser General Public License
+    along with this program.  If not, see <http://www.gnu.org/licenses/>.
+*/
+#ifndef SEQLOCK_H
+#define SEQLOCK_H
+
+#include <atomic>
+#include <cstring>
+#include <type_traits>
+#include <thread>
+
+/**
+ * A value that many threads can read without ever taking a lock.
+ *
+ * Writers bump a sequence number to an odd value, store the new value
+ * and bump it again. Readers copy the value and retry if the sequence
+ * was odd or changed meanwhile, so they never block a writer and never
+ * see a torn value. Writers are serialized among themselves by spinning
+ * on the sequence; they are expected to be rare (property changes).
+ *
+ * The value is kept in relaxed atomic words, which makes the concurrent
+ * copy well defined. T must therefore be trivially copyable.
+ */
+template <typename T>
+class SeqLock
+{
+    static_assert(std::is_trivially_copyable<T>::value,
+                  "SeqLock can only hold trivially copyable types");
+
+public:
+    explicit SeqLock(const T & value = T())
+        : m_sequence(0)
+    {
+        storeWords(value);
+    }
+
+    // a consistent copy of the current value
+    T load() const
+    {
+        T value;
+        load(&value);
+        return value;
+    }
+
+    // same as above, also returning how many writes preceded this value
+    unsigned int load(T *value) const
+    {
+        Word words[Num_Words];
+        for (;;) {
+            const unsigned int before = m_sequence.load(std::memory_order_acquire);
+            if (before & 1) {
+                std::this_thread::yield();
+                continue;
+            }
+
+            for (int i = 0; i < Num_Words; i++)
+                words[i] = m_words[i].load(std::memory_order_relaxed);
+
+            std::atomic_thread_fence(std::memory_order_acquire);
+            if (m_sequence.load(std::memory_order_relaxed) == before) {
+                std::memcpy(value, words, sizeof(T));
+                return before / 2;
+            }
+        }
+    }
+
+    // replaces the value
+    void store(const T & value)
+    {
+        const unsigned int sequence = lockForWrite();
+        storeWords(value);
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+    // atomically applies a change to the value; fn is called with a
+    // T & to modify and should be short, as readers spin meanwhile
+    template <typename Function>
+    void modify(Function fn)
+    {
+        const unsigned int sequence = lockForWrite();
+
+        // no other writer can be active, so plain relaxed loads are exact
+        Word words[Num_Words];
+        for (int i = 0; i < Num_Words; i++)
+            words[i] = m_words[i].load(std::memory_order_relaxed);
+
+        T value;
+        std::memcpy(&value, words, sizeof(T));
+        fn(value);
+        storeWords(value);
+
+        m_sequence.store(sequence + 2, std::memory_order_release);
+    }
+
+private:
+    typedef unsigned int Word;
+    static const int Num_Words = (sizeof(T) + sizeof(Word) - 1) / sizeof(Word);
+
+    unsigned int lockForWrite()
+    {
+        unsigned int sequence = m_sequence.load(std::memory_order_relaxed);
+        for (;;) {
+            if (!(sequence & 1) && m_sequence.compare_exchange_weak(sequence, sequence + 1,
+                                                                    std::memory_order_acquire,
+                                                                    std::memory_order_relaxed)) {
+                // make the odd sequence visible before any of the new words
+                std::atomic_thread_fence(std::memory_order_release);
+                return sequence;
+            }
+            std::this_thread::yield();
+            sequence = m_sequence.load(std::memory_order_relaxed);
+        }
+    }
+
+    void storeWords(const T & value)
+    {
+        Word words[Num_Words] = {};
+        std::memcpy(words, &value, sizeof(T));
+        for (int i = 0; i < Num_Words; i++)
+            m_words[i].store(words[i], std::memory_order_relaxed);
+    }
+
+    std::atomic<unsigned int> m_sequence;
+    std::atomic<Word> m_words[Num_Words];
+
+    SeqLock(const SeqLock &);
+    SeqLock & operator=(const SeqLock &);
+};
+
+#endif // SEQLOCK_H
@@ -82,7 +82,7 @@ GridView {
                         view.model.remove(index)
                     }
 
-                    description: "filesrc location=\"" + view.sampleImage + "\" ! decodebin ! imagefreeze ! videoconvert ! " + model.filters + " name=last"
+                    description: "filesrc location=\"" + view.sampleImage + "\" ! decodebin ! imagefreeze ! videoconvert ! videoscale ! " + model.filters + " name=last"
                 }
                 surface: pipe.surface
             }
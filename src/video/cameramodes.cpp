@@ -0,0 +1,325 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "cameramodes.h"
+#include <device.h>
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QThread>
+#include <QDebug>
+
+#include <algorithm>
+#include <tuple>
+
+// what ranges are narrowed down to, largest first
+static const QSize s_commonSizes[] = {
+    QSize(1920, 1080), QSize(1280, 720), QSize(800, 600), QSize(640, 480), QSize(320, 240)
+};
+static const int s_commonFramerates[] = { 60, 30, 25, 24, 15, 10, 5 };
+
+// a frame rate the viewfinder does not look choppy at
+static const int Smooth_Framerate = 24;
+
+// past this, more frames per second go unnoticed in a viewfinder
+static const int Max_Useful_Framerate = 30;
+
+// decoding a JPEG pixel takes about as long as copying three raw ones
+static const qreal Jpeg_Cost = 3;
+
+// raw pixels per second one core keeps up with, along with everything
+// else the viewfinder does
+static const qreal Budget_Per_Core = 200e6;
+
+GstCaps *CameraMode::caps() const
+{
+    GstStructure *structure = gst_structure_new(mediaType.constData(),
+                                                "width", G_TYPE_INT, size.width(),
+                                                "height", G_TYPE_INT, size.height(),
+                                                "framerate", GST_TYPE_FRACTION, framerateNumerator, framerateDenominator,
+                                                nullptr);
+    if (!format.isEmpty())
+        gst_structure_set(structure, "format", G_TYPE_STRING, format.constData(), nullptr);
+    return gst_caps_new_full(structure, nullptr);
+}
+
+QString CameraMode::toString() const
+{
+    GstCaps *c = caps();
+    gchar *string = gst_caps_to_string(c);
+    const QString ret = QString::fromUtf8(string);
+    g_free(string);
+    gst_caps_unref(c);
+    return ret;
+}
+
+CameraMode CameraMode::fromString(const QString &string)
+{
+    GstCaps *caps = gst_caps_from_string(string.toUtf8().constData());
+    if (!caps)
+        return {};
+
+    // a single mode was saved, anything else is not one of ours
+    const QVector<CameraMode> modes = CameraModes::fromCaps(caps);
+    gst_caps_unref(caps);
+    return modes.size() == 1 ? modes.first() : CameraMode();
+}
+
+bool CameraMode::operator==(const CameraMode &other) const
+{
+    return mediaType == other.mediaType && format == other.format && size == other.size
+        && framerateNumerator == other.framerateNumerator
+        && framerateDenominator == other.framerateDenominator;
+}
+
+// whether a caps field, fixed or not, allows the given value
+static bool allows(const GValue *field, const GValue *value)
+{
+    return !field || gst_value_intersect(nullptr, field, value);
+}
+
+static void addFormats(const GValue *field, QVector<QByteArray> *formats)
+{
+    if (G_VALUE_HOLDS_STRING(field)) {
+        *formats << QByteArray(g_value_get_string(field));
+    } else if (GST_VALUE_HOLDS_LIST(field)) {
+        for (guint i = 0, n = gst_value_list_get_size(field); i < n; ++i)
+            addFormats(gst_value_list_get_value(field, i), formats);
+    }
+}
+
+static QVector<QSize> sizes(const GstStructure *structure)
+{
+    int width, height;
+    if (gst_structure_get_int(structure, "width", &width) && gst_structure_get_int(structure, "height", &height))
+        return { QSize(width, height) };
+
+    // a range, or a list: what cameras usually do that fits in it
+    const GValue *widths = gst_structure_get_value(structure, "width");
+    const GValue *heights = gst_structure_get_value(structure, "height");
+    QVector<QSize> ret;
+    for (const QSize &size : s_commonSizes) {
+        GValue w = G_VALUE_INIT, h = G_VALUE_INIT;
+        g_value_init(&w, G_TYPE_INT);
+        g_value_init(&h, G_TYPE_INT);
+        g_value_set_int(&w, size.width());
+        g_value_set_int(&h, size.height());
+        if (allows(widths, &w) && allows(heights, &h))
+            ret << size;
+        g_value_unset(&w);
+        g_value_unset(&h);
+    }
+    return ret;
+}
+
+static void addFramerates(const GValue *field, QVector<QPair<int, int>> *framerates)
+{
+    if (field && GST_VALUE_HOLDS_FRACTION(field)) {
+        *framerates << qMakePair(gst_value_get_fraction_numerator(field),
+                                 gst_value_get_fraction_denominator(field));
+    } else if (field && GST_VALUE_HOLDS_LIST(field)) {
+        for (guint i = 0, n = gst_value_list_get_size(field); i < n; ++i)
+            addFramerates(gst_value_list_get_value(field, i), framerates);
+    } else {
+        for (int framerate : s_commonFramerates) {
+            GValue value = G_VALUE_INIT;
+            g_value_init(&value, GST_TYPE_FRACTION);
+            gst_value_set_fraction(&value, framerate, 1);
+            if (allows(field, &value))
+                *framerates << qMakePair(framerate, 1);
+            g_value_unset(&value);
+        }
+    }
+}
+
+QVector<CameraMode> CameraModes::fromCaps(const GstCaps *caps)
+{
+    QVector<CameraMode> modes;
+    if (!caps || gst_caps_is_any(caps))
+        return modes;
+
+    for (guint i = 0, n = gst_caps_get_size(caps); i < n; ++i) {
+        const GstStructure *structure = gst_caps_get_structure(caps, i);
+        const QByteArray mediaType = gst_structure_get_name(structure);
+
+        // whatever else is there, the viewfinder cannot show without help
+        QVector<QByteArray> formats;
+        if (mediaType == "video/x-raw") {
+            addFormats(gst_structure_get_value(structure, "format"), &formats);
+        } else if (mediaType == "image/jpeg") {
+            formats << QByteArray();
+        } else {
+            continue;
+        }
+
+        QVector<QPair<int, int>> framerates;
+        addFramerates(gst_structure_get_value(structure, "framerate"), &framerates);
+
+        for (const QSize &size : sizes(structure)) {
+            for (const QByteArray &format : qAsConst(formats)) {
+                for (const auto &framerate : qAsConst(framerates)) {
+                    // 0/1 means a variable rate, nothing to rank by
+                    if (framerate.first <= 0 || framerate.second <= 0)
+                        continue;
+
+                    CameraMode mode;
+                    mode.mediaType = mediaType;
+                    mode.format = format;
+                    mode.size = size;
+                    mode.framerateNumerator = framerate.first;
+                    mode.framerateDenominator = framerate.second;
+                    if (!modes.contains(mode))
+                        modes << mode;
+                }
+            }
+        }
+    }
+    return modes;
+}
+
+QVector<CameraMode> CameraModes::probe(GstElement *source)
+{
+    QVector<CameraMode> modes;
+
+    // v4l2src only knows what the device does once it has opened it
+    if (gst_element_set_state(source, GST_STATE_READY) != GST_STATE_CHANGE_FAILURE) {
+        GstPad *pad = gst_element_get_static_pad(source, "src");
+        if (pad) {
+            GstCaps *caps = gst_pad_query_caps(pad, nullptr);
+            modes = fromCaps(caps);
+            gst_caps_unref(caps);
+            gst_object_unref(pad);
+        }
+    }
+    gst_element_set_state(source, GST_STATE_NULL);
+    return modes;
+}
+
+qreal CameraModes::cost(const CameraMode &mode)
+{
+    const qreal pixels = qreal(mode.size.width()) * mode.size.height() * mode.framerate();
+    return mode.isJpeg() ? pixels * Jpeg_Cost : pixels;
+}
+
+qreal CameraModes::defaultBudget()
+{
+    // qtjpegdec decodes on every core; half of them are left to the rest
+    // of the desktop, and a single one is shared with the UI
+    const int cores = QThread::idealThreadCount();
+    return cores > 1 ? Budget_Per_Core * (cores / 2) : Budget_Per_Core / 2;
+}
+
+QVector<CameraMode> CameraModes::rank(QVector<CameraMode> modes, qreal budget,
+                                      const QVector<CameraMode> &excluded)
+{
+    modes.erase(std::remove_if(modes.begin(), modes.end(), [&excluded](const CameraMode &mode) {
+        return excluded.contains(mode);
+    }), modes.end());
+
+    auto key = [budget](const CameraMode &mode) {
+        // if nothing is affordable, the cheapest will have to do
+        const qreal c = cost(mode);
+        if (c > budget)
+            return std::make_tuple(false, false, 0, qreal(0), -c);
+        return std::make_tuple(true,
+                               mode.framerate() >= Smooth_Framerate,
+                               mode.size.width() * mode.size.height(),
+                               qMin(mode.framerate(), qreal(Max_Useful_Framerate)),
+                               -c);
+    };
+    std::stable_sort(modes.begin(), modes.end(), [&key](const CameraMode &a, const CameraMode &b) {
+        return key(a) > key(b);
+    });
+    return modes;
+}
+
+CameraMode CameraModes::best(const QVector<CameraMode> &modes, qreal budget,
+                             const QVector<CameraMode> &excluded)
+{
+    const QVector<CameraMode> ranked = rank(modes, budget, excluded);
+    return ranked.isEmpty() ? CameraMode() : ranked.first();
+}
+
+QVector<CameraMode> CameraModes::load(const KConfigGroup &group, const QString &udi, const QString &description)
+{
+    QVector<CameraMode> modes;
+    const KConfigGroup device = group.group(udi);
+
+    // another camera plugged into the same port
+    if (device.readEntry("description", QString()) != description)
+        return modes;
+
+    const QStringList strings = device.readEntry("modes", QStringList());
+    for (const QString &string : strings) {
+        const CameraMode mode = CameraMode::fromString(string);
+        if (mode.isValid())
+            modes << mode;
+    }
+    return modes;
+}
+
+void CameraModes::save(KConfigGroup &group, const QString &udi, const QString &description,
+                       const QVector<CameraMode> &modes)
+{
+    QStringList strings;
+    for (const CameraMode &mode : modes)
+        strings << mode.toString();
+
+    KConfigGroup device = group.group(udi);
+    device.writeEntry("description", description);
+    device.writeEntry("modes", strings);
+}
+
+static KConfigGroup cacheGroup()
+{
+    return KConfigGroup(KSharedConfig::openConfig(QStringLiteral("kamosorc")), "CameraModes");
+}
+
+QVector<CameraMode> CameraModes::forDevice(const Device *device)
+{
+    KConfigGroup group = cacheGroup();
+    QVector<CameraMode> modes = load(group, device->udi(), device->description());
+    if (!modes.isEmpty())
+        return modes;
+
+    GstElement *source = gst_element_factory_make("v4l2src", nullptr);
+    if (!source) {
+        qWarning() << "could not probe" << device->path() << "without v4l2src";
+        return modes;
+    }
+
+    gst_object_ref_sink(source);
+    g_object_set(source, "device", device->path().toUtf8().constData(), nullptr);
+    modes = probe(source);
+    gst_object_unref(source);
+
+    qDebug() << "probed" << modes.size() << "modes for" << device->description();
+    if (!modes.isEmpty()) {
+        save(group, device->udi(), device->description(), modes);
+        group.sync();
+    }
+    return modes;
+}
+
+void CameraModes::forget(const Device *device)
+{
+    KConfigGroup group = cacheGroup();
+    group.deleteGroup(device->udi());
+    group.sync();
+}
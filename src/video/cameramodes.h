@@ -0,0 +1,99 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef CAMERAMODES_H
+#define CAMERAMODES_H
+
+#include <QSize>
+#include <QString>
+#include <QVector>
+
+#include <gst/gst.h>
+
+class Device;
+class KConfigGroup;
+
+/**
+ * One way a camera can deliver its frames: raw in some format, or
+ * compressed as JPEG, at a given size and rate.
+ */
+struct CameraMode
+{
+    bool isValid() const { return !size.isEmpty() && framerateNumerator > 0; }
+    bool isJpeg() const { return mediaType == "image/jpeg"; }
+    qreal framerate() const { return qreal(framerateNumerator) / framerateDenominator; }
+
+    // the caps of the frames as they leave the camera, to be unreffed
+    GstCaps *caps() const;
+
+    // how it is kept in kamosorc
+    QString toString() const;
+    static CameraMode fromString(const QString &string);
+
+    bool operator==(const CameraMode &other) const;
+
+    QByteArray mediaType;
+    QByteArray format; // raw video only
+    QSize size;
+    int framerateNumerator = 0;
+    int framerateDenominator = 1;
+};
+
+/**
+ * Finds out what a camera can do and which of it is worth using.
+ *
+ * Probing opens the device, so the results are kept per udi in kamosorc
+ * and only probed again when another device shows up at the same place,
+ * or when the mode picked last did not work.
+ */
+namespace CameraModes
+{
+    // every mode the caps allow; ranges are narrowed down to common
+    // sizes and rates
+    QVector<CameraMode> fromCaps(const GstCaps *caps);
+
+    // asks a source element, which is taken to READY for that
+    QVector<CameraMode> probe(GstElement *source);
+
+    // what showing a mode costs per second, in raw pixels copied
+    qreal cost(const CameraMode &mode);
+
+    // how much of that the viewfinder can afford on this machine
+    qreal defaultBudget();
+
+    // best first: affordable, then smooth, then large, then cheap. The
+    // excluded modes, e.g. those that failed already, are left out
+    QVector<CameraMode> rank(QVector<CameraMode> modes, qreal budget,
+                             const QVector<CameraMode> &excluded = QVector<CameraMode>());
+
+    // an invalid mode if there are none left
+    CameraMode best(const QVector<CameraMode> &modes, qreal budget = defaultBudget(),
+                    const QVector<CameraMode> &excluded = QVector<CameraMode>());
+
+    // the cache; empty if there is nothing for this device
+    QVector<CameraMode> load(const KConfigGroup &group, const QString &udi, const QString &description);
+    void save(KConfigGroup &group, const QString &udi, const QString &description,
+              const QVector<CameraMode> &modes);
+
+    // from the cache in kamosorc, probing the device if needed; the
+    // device must not be in use
+    QVector<CameraMode> forDevice(const Device *device);
+    void forget(const Device *device);
+}
+
+#endif // CAMERAMODES_H
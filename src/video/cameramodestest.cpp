@@ -0,0 +1,192 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "cameramodes.h"
+
+#include <KConfigGroup>
+#include <KSharedConfig>
+
+#include <QTest>
+#include <QTemporaryDir>
+
+class CameraModesTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testFromCaps();
+    void testRank_data();
+    void testRank();
+    void testExcluded();
+    void testVideoTestSrc();
+    void testCache();
+    void testVivid();
+};
+
+static QVector<CameraMode> modesFromString(const char *string)
+{
+    GstCaps *caps = gst_caps_from_string(string);
+    const QVector<CameraMode> modes = CameraModes::fromCaps(caps);
+    gst_caps_unref(caps);
+    return modes;
+}
+
+// what a typical UVC camera reports: VGA and a slow 1080p uncompressed,
+// the rest as MJPEG
+static const char * const s_uvcCaps =
+    "video/x-raw, format=(string)YUY2, width=(int)640, height=(int)480, framerate=(fraction){30/1, 15/1}; "
+    "video/x-raw, format=(string)YUY2, width=(int)1920, height=(int)1080, framerate=(fraction)5/1; "
+    "image/jpeg, width=(int)1920, height=(int)1080, framerate=(fraction){30/1, 15/1}; "
+    "image/jpeg, width=(int)1280, height=(int)720, framerate=(fraction)30/1; "
+    "video/x-h264, width=(int)1920, height=(int)1080, framerate=(fraction)30/1";
+
+void CameraModesTest::initTestCase()
+{
+    gst_init(nullptr, nullptr);
+}
+
+void CameraModesTest::testFromCaps()
+{
+    const QVector<CameraMode> modes = modesFromString(s_uvcCaps);
+    QCOMPARE(modes.size(), 6);
+
+    for (const CameraMode &mode : modes) {
+        QVERIFY(mode.isValid());
+        QCOMPARE(CameraMode::fromString(mode.toString()), mode);
+    }
+
+    // ranges are narrowed down to common values
+    const QVector<CameraMode> ranged = modesFromString(
+        "video/x-raw, format=(string){YUY2, NV12}, width=(int)[ 160, 1280 ], height=(int)[ 120, 720 ], "
+        "framerate=(fraction)[ 10/1, 30/1 ]");
+    QVERIFY(!ranged.isEmpty());
+    for (const CameraMode &mode : ranged) {
+        QVERIFY(mode.size.width() <= 1280 && mode.size.height() <= 720);
+        QVERIFY(mode.framerate() >= 10 && mode.framerate() <= 30);
+    }
+    CameraMode hd;
+    hd.mediaType = "video/x-raw";
+    hd.format = "NV12";
+    hd.size = QSize(1280, 720);
+    hd.framerateNumerator = 25;
+    QVERIFY(ranged.contains(hd));
+}
+
+void CameraModesTest::testRank_data()
+{
+    QTest::addColumn<qreal>("budget");
+    QTest::addColumn<QByteArray>("mediaType");
+    QTest::addColumn<QSize>("size");
+    QTest::addColumn<int>("framerate");
+
+    QTest::newRow("fast") << 200e6 << QByteArray("image/jpeg") << QSize(1920, 1080) << 30;
+    QTest::newRow("medium") << 100e6 << QByteArray("image/jpeg") << QSize(1280, 720) << 30;
+    QTest::newRow("slow") << 20e6 << QByteArray("video/x-raw") << QSize(640, 480) << 30;
+    QTest::newRow("none") << 1.0 << QByteArray("video/x-raw") << QSize(640, 480) << 15;
+}
+
+void CameraModesTest::testRank()
+{
+    QFETCH(qreal, budget);
+    QFETCH(QByteArray, mediaType);
+    QFETCH(QSize, size);
+    QFETCH(int, framerate);
+
+    const CameraMode best = CameraModes::best(modesFromString(s_uvcCaps), budget);
+    QCOMPARE(best.mediaType, mediaType);
+    QCOMPARE(best.size, size);
+    QCOMPARE(best.framerate(), qreal(framerate));
+}
+
+void CameraModesTest::testExcluded()
+{
+    const QVector<CameraMode> modes = modesFromString(s_uvcCaps);
+
+    // the 1080p MJPEG mode fails, e.g. for lack of USB bandwidth
+    QVector<CameraMode> failed;
+    CameraMode mode = CameraModes::best(modes, 200e6);
+    QCOMPARE(mode.size, QSize(1920, 1080));
+    failed << mode;
+
+    mode = CameraModes::best(modes, 200e6, failed);
+    QCOMPARE(mode.size, QSize(1280, 720));
+    QVERIFY(!failed.contains(mode));
+    QCOMPARE(CameraModes::rank(modes, 200e6, failed).size(), modes.size() - 1);
+
+    // with every mode failed, nothing is left and the caller falls back
+    QVERIFY(!CameraModes::best(modes, 200e6, modes).isValid());
+    QVERIFY(CameraModes::rank(modes, 200e6, modes).isEmpty());
+}
+
+void CameraModesTest::testVideoTestSrc()
+{
+    GstElement *source = gst_element_factory_make("videotestsrc", nullptr);
+    QVERIFY(source);
+    gst_object_ref_sink(source);
+    const QVector<CameraMode> modes = CameraModes::probe(source);
+    gst_object_unref(source);
+
+    QVERIFY(!modes.isEmpty());
+    const CameraMode best = CameraModes::best(modes, 1e12);
+    QCOMPARE(best.mediaType, QByteArray("video/x-raw"));
+    QCOMPARE(best.size, QSize(1920, 1080));
+    QCOMPARE(best.framerate(), qreal(30));
+}
+
+void CameraModesTest::testCache()
+{
+    QTemporaryDir dir;
+    KSharedConfig::Ptr config = KSharedConfig::openConfig(dir.filePath(QStringLiteral("kamosorc")),
+                                                          KConfig::SimpleConfig);
+    KConfigGroup group(config, "CameraModes");
+
+    const QString udi = QStringLiteral("/sys/devices/pci0000:00/usb1/1-1/video4linux/video0");
+    const QVector<CameraMode> modes = modesFromString(s_uvcCaps);
+    QVERIFY(CameraModes::load(group, udi, QStringLiteral("Camera")).isEmpty());
+
+    CameraModes::save(group, udi, QStringLiteral("Camera"), modes);
+    config->sync();
+    config->reparseConfiguration();
+
+    QCOMPARE(CameraModes::load(group, udi, QStringLiteral("Camera")), modes);
+    QVERIFY(CameraModes::load(group, udi, QStringLiteral("Another Camera")).isEmpty());
+}
+
+// modprobe vivid, then point KAMOSO_TEST_VIVID_DEVICE to its capture node
+void CameraModesTest::testVivid()
+{
+    const QByteArray path = qgetenv("KAMOSO_TEST_VIVID_DEVICE");
+    if (path.isEmpty())
+        QSKIP("KAMOSO_TEST_VIVID_DEVICE is not set");
+
+    GstElement *source = gst_element_factory_make("v4l2src", nullptr);
+    if (!source)
+        QSKIP("v4l2src is not installed");
+    gst_object_ref_sink(source);
+    g_object_set(source, "device", path.constData(), nullptr);
+    const QVector<CameraMode> modes = CameraModes::probe(source);
+    gst_object_unref(source);
+
+    QVERIFY(!modes.isEmpty());
+    const CameraMode best = CameraModes::best(modes);
+    QVERIFY(best.isValid());
+    QVERIFY(CameraModes::cost(best) <= CameraModes::defaultBudget());
+}
+
+QTEST_GUILESS_MAIN(CameraModesTest)
+#include "cameramodestest.moc"
@@ -0,0 +1,147 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "filterswapper.h"
+
+#include <QDebug>
+
+FilterSwapper::FilterSwapper(const char *name)
+    : m_bin(gst_bin_new(name))
+    , m_head(gst_element_factory_make("identity", "head"))
+    , m_tail(gst_element_factory_make("identity", "tail"))
+{
+    gst_object_ref_sink(m_bin);
+    gst_bin_add_many(GST_BIN(m_bin), m_head, m_tail, nullptr);
+    gst_element_link(m_head, m_tail);
+
+    GstPad *sink = gst_element_get_static_pad(m_head, "sink");
+    gst_element_add_pad(m_bin, gst_ghost_pad_new("sink", sink));
+    gst_object_unref(sink);
+
+    GstPad *src = gst_element_get_static_pad(m_tail, "src");
+    gst_element_add_pad(m_bin, gst_ghost_pad_new("src", src));
+    gst_object_unref(src);
+}
+
+FilterSwapper::~FilterSwapper()
+{
+    if (m_probe) {
+        GstPad *pad = gst_element_get_static_pad(m_head, "src");
+        gst_pad_remove_probe(pad, m_probe);
+        gst_object_unref(pad);
+    }
+    gst_object_unref(m_bin);
+}
+
+QString FilterSwapper::filters() const
+{
+    QMutexLocker l(&m_mutex);
+    return m_filters;
+}
+
+void FilterSwapper::setFilters(const QString &filters)
+{
+    {
+        QMutexLocker l(&m_mutex);
+        m_filters = filters;
+        // a swap on its way picks these up
+        if (m_swapPending || m_filters == m_current)
+            return;
+        m_swapPending = true;
+    }
+
+    // called right away if the pad is idle, from the streaming thread once
+    // the frame being pushed is through otherwise
+    GstPad *pad = gst_element_get_static_pad(m_head, "src");
+    const gulong probe = gst_pad_add_probe(pad, GST_PAD_PROBE_TYPE_IDLE, &FilterSwapper::onIdle, this, nullptr);
+    gst_object_unref(pad);
+
+    // unless it is done already
+    QMutexLocker l(&m_mutex);
+    if (m_swapPending)
+        m_probe = probe;
+}
+
+GstPadProbeReturn FilterSwapper::onIdle(GstPad */*pad*/, GstPadProbeInfo */*info*/, gpointer self)
+{
+    static_cast<FilterSwapper*>(self)->swap();
+    return GST_PAD_PROBE_REMOVE;
+}
+
+void FilterSwapper::swap()
+{
+    // setFilters may be called again meanwhile
+    for (;;) {
+        QString filters;
+        {
+            QMutexLocker l(&m_mutex);
+            if (m_filters == m_current) {
+                m_swapPending = false;
+                m_probe = 0;
+                return;
+            }
+            filters = m_filters;
+        }
+        replace(filters);
+    }
+}
+
+void FilterSwapper::replace(const QString &filters)
+{
+    if (m_filter) {
+        gst_element_unlink_many(m_head, m_filter, m_tail, nullptr);
+        gst_element_set_state(m_filter, GST_STATE_NULL);
+        gst_bin_remove(GST_BIN(m_bin), m_filter);
+        m_filter = nullptr;
+    } else {
+        gst_element_unlink(m_head, m_tail);
+    }
+
+    if (!filters.isEmpty()) {
+        // the filters get the frames in a format they take
+        const QByteArray description = "videoconvert ! " + filters.toUtf8();
+        GError *error = nullptr;
+        m_filter = gst_parse_bin_from_description(description.constData(), true, &error);
+        if (error) {
+            qWarning() << "cannot use filters" << filters << error->message;
+            g_error_free(error);
+            if (m_filter)
+                gst_object_unref(m_filter);
+            m_filter = nullptr;
+        }
+    }
+
+    if (m_filter) {
+        gst_bin_add(GST_BIN(m_bin), m_filter);
+        gst_element_link_many(m_head, m_filter, m_tail, nullptr);
+        gst_element_sync_state_with_parent(m_filter);
+    } else {
+        gst_element_link(m_head, m_tail);
+    }
+
+    // the frames may fit the new filters better in another format
+    GstPad *pad = gst_element_get_static_pad(m_tail, "sink");
+    gst_pad_push_event(pad, gst_event_new_reconfigure());
+    gst_object_unref(pad);
+
+    {
+        QMutexLocker l(&m_mutex);
+        m_current = filters;
+    }
+    m_generation.ref();
+}
@@ -0,0 +1,72 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef FILTERSWAPPER_H
+#define FILTERSWAPPER_H
+
+#include <QAtomicInt>
+#include <QMutex>
+#include <QString>
+
+#include <gst/gst.h>
+
+/**
+ * A bin whose filters can be changed while video goes through it.
+ *
+ * The bin goes into the pipeline once. Changing the filters waits until
+ * no frame is on its way through, then relinks the new elements in
+ * place of the old ones, so the pipeline never leaves its state and the
+ * camera stays open.
+ */
+class FilterSwapper
+{
+public:
+    explicit FilterSwapper(const char *name);
+    ~FilterSwapper();
+
+    GstElement *bin() const { return m_bin; }
+
+    // a gst-launch description of raw video filters, or empty for none.
+    // Applied before the next frame, or right away if there is none
+    void setFilters(const QString &filters);
+    QString filters() const;
+
+    // bumped each time other filters are in place
+    int generation() const { return m_generation.load(); }
+
+private:
+    Q_DISABLE_COPY(FilterSwapper)
+
+    static GstPadProbeReturn onIdle(GstPad *pad, GstPadProbeInfo *info, gpointer self);
+    void swap();
+    void replace(const QString &filters);
+
+    GstElement *m_bin;
+    GstElement *m_head;
+    GstElement *m_tail;
+    GstElement *m_filter = nullptr; // none if the ends are linked together
+
+    mutable QMutex m_mutex;
+    QString m_filters; // wanted
+    QString m_current; // in place
+    bool m_swapPending = false;
+    gulong m_probe = 0;
+    QAtomicInt m_generation;
+};
+
+#endif // FILTERSWAPPER_H
@@ -0,0 +1,171 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+/* How long a new effect takes to show, counted in frames and milliseconds
+ * from selecting it to the first frame that went through it. Prints one
+ * CSV line per effect:
+ *
+ *   filterswapper_bench --device /dev/video0
+ *
+ * With --rebuild, the effects are changed the way they used to be, by
+ * taking the pipeline to NULL and back, for comparison. Without a device,
+ * a live videotestsrc stands in for the camera. */
+
+#include "filterswapper.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QTextStream>
+#include <QThread>
+
+static const char * const s_effects[] = {
+    "videobalance saturation=0",
+    "coloreffects preset=sepia",
+    "videoflip method=4",
+    "gamma gamma=2",
+    ""
+};
+
+struct Counter
+{
+    QAtomicInt frames;
+
+    // the first frame of a new generation, -1 until it is through
+    const FilterSwapper *swapper = nullptr;
+    QAtomicInt waitingFor;
+    QAtomicInt firstFrame;
+    QAtomicInteger<qint64> firstFrameTime;
+    QElapsedTimer timer;
+};
+
+static void onHandoff(GstElement *, GstBuffer *, GstPad *, Counter *counter)
+{
+    const int frame = counter->frames.fetchAndAddOrdered(1) + 1;
+    if (counter->firstFrame.load() < 0 && counter->swapper->generation() >= counter->waitingFor.load()) {
+        counter->firstFrameTime.store(counter->timer.nsecsElapsed());
+        counter->firstFrame.store(frame);
+    }
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication app(argc, argv);
+    gst_init(&argc, &argv);
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Measures how long a new effect takes to show"));
+    parser.addHelpOption();
+    QCommandLineOption deviceOption(QStringLiteral("device"),
+            QStringLiteral("V4L2 device to read from instead of videotestsrc"), QStringLiteral("path"));
+    QCommandLineOption rebuildOption(QStringLiteral("rebuild"),
+            QStringLiteral("Take the pipeline to NULL for each effect"));
+    QCommandLineOption roundsOption(QStringLiteral("rounds"),
+            QStringLiteral("Times to go through the effects"), QStringLiteral("count"), QStringLiteral("3"));
+    parser.addOption(deviceOption);
+    parser.addOption(rebuildOption);
+    parser.addOption(roundsOption);
+    parser.process(app);
+
+    const QByteArray source = parser.isSet(deviceOption)
+            ? "v4l2src device=" + parser.value(deviceOption).toUtf8()
+            : QByteArray("videotestsrc is-live=true ! video/x-raw, width=640, height=480, framerate=30/1");
+    const bool rebuild = parser.isSet(rebuildOption);
+    const int rounds = qMax(1, parser.value(roundsOption).toInt());
+
+    GError *error = nullptr;
+    GstElement *pipeline = gst_parse_launch((source + " ! identity name=before").constData(), &error);
+    if (!pipeline) {
+        qCritical("%s", error->message);
+        return 1;
+    }
+
+    FilterSwapper swapper("filter");
+    GstElement *sink = gst_element_factory_make("fakesink", nullptr);
+    g_object_set(sink, "sync", TRUE, "signal-handoffs", TRUE, nullptr);
+
+    Counter counter;
+    counter.swapper = &swapper;
+    counter.waitingFor.store(0);
+    counter.firstFrame.store(0);
+    counter.timer.start();
+    g_signal_connect(sink, "handoff", G_CALLBACK(onHandoff), &counter);
+
+    gst_bin_add_many(GST_BIN(pipeline), swapper.bin(), sink, nullptr);
+    GstElement *before = gst_bin_get_by_name(GST_BIN(pipeline), "before");
+    gst_element_link_many(before, swapper.bin(), sink, nullptr);
+    gst_object_unref(before);
+
+    gst_element_set_state(pipeline, GST_STATE_PLAYING);
+    GstBus *bus = gst_element_get_bus(pipeline);
+
+    QTextStream out(stdout);
+    out << "effect,frames,ms" << endl;
+
+    int failures = 0;
+    for (int round = 0; round < rounds; round++) {
+        for (const char *effect : s_effects) {
+            // let it settle first
+            const int settled = counter.frames.load() + 15;
+            while (counter.frames.load() < settled) {
+                GstMessage *message = gst_bus_timed_pop_filtered(bus, 10 * GST_MSECOND, GST_MESSAGE_ERROR);
+                if (message) {
+                    gst_message_parse_error(message, &error, nullptr);
+                    qCritical("%s", error->message);
+                    g_error_free(error);
+                    gst_message_unref(message);
+                    return 1;
+                }
+            }
+
+            const int requestFrame = counter.frames.load();
+            const qint64 requestTime = counter.timer.nsecsElapsed();
+            counter.firstFrame.store(-1);
+            counter.waitingFor.store(swapper.generation() + 1);
+
+            if (rebuild) {
+                gst_element_set_state(pipeline, GST_STATE_NULL);
+                swapper.setFilters(QString::fromUtf8(effect));
+                gst_element_set_state(pipeline, GST_STATE_PLAYING);
+            } else {
+                swapper.setFilters(QString::fromUtf8(effect));
+            }
+
+            QElapsedTimer timeout;
+            timeout.start();
+            while (counter.firstFrame.load() < 0 && timeout.elapsed() < 10000)
+                QThread::msleep(1);
+
+            if (counter.firstFrame.load() < 0) {
+                qWarning("no frame went through %s", effect);
+                failures++;
+                continue;
+            }
+
+            // frames counted from NULL again in rebuild mode are still frames
+            out << '"' << effect << "\","
+                << qMax(0, counter.firstFrame.load() - requestFrame) << ','
+                << QString::number((counter.firstFrameTime.load() - requestTime) / 1e6, 'f', 1) << endl;
+        }
+    }
+
+    gst_object_unref(bus);
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+    return failures ? 1 : 0;
+}
@@ -0,0 +1,125 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "filterswapper.h"
+
+#include <QTest>
+
+class FilterSwapperTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testStopped();
+    void testPlaying();
+};
+
+static bool contains(GstElement *bin, const char *factory)
+{
+    bool found = false;
+    GstIterator *it = gst_bin_iterate_recurse(GST_BIN(bin));
+    GValue item = G_VALUE_INIT;
+    while (gst_iterator_next(it, &item) == GST_ITERATOR_OK) {
+        GstElement *element = GST_ELEMENT(g_value_get_object(&item));
+        GstElementFactory *f = gst_element_get_factory(element);
+        if (f && g_strcmp0(GST_OBJECT_NAME(f), factory) == 0)
+            found = true;
+        g_value_reset(&item);
+    }
+    g_value_unset(&item);
+    gst_iterator_free(it);
+    return found;
+}
+
+static void countFrame(GstElement *, GstBuffer *, GstPad *, QAtomicInt *frames)
+{
+    frames->ref();
+}
+
+void FilterSwapperTest::initTestCase()
+{
+    gst_init(nullptr, nullptr);
+}
+
+void FilterSwapperTest::testStopped()
+{
+    // nothing flows, so the filters are swapped right away
+    FilterSwapper swapper("filter");
+    swapper.setFilters(QStringLiteral("videoflip method=4"));
+    QCOMPARE(swapper.generation(), 1);
+    QVERIFY(contains(swapper.bin(), "videoflip"));
+
+    swapper.setFilters(QStringLiteral("videoflip method=4"));
+    QCOMPARE(swapper.generation(), 1);
+
+    swapper.setFilters(QString());
+    QCOMPARE(swapper.generation(), 2);
+    QVERIFY(!contains(swapper.bin(), "videoflip"));
+}
+
+void FilterSwapperTest::testPlaying()
+{
+    GstElement *pipeline = gst_parse_launch(
+        "videotestsrc is-live=true ! video/x-raw, format=I420, width=64, height=48, framerate=100/1 "
+        "! identity name=before", nullptr);
+    QVERIFY(pipeline);
+
+    FilterSwapper swapper("filter");
+    GstElement *sink = gst_element_factory_make("fakesink", nullptr);
+    g_object_set(sink, "sync", FALSE, "signal-handoffs", TRUE, nullptr);
+    QAtomicInt frames;
+    g_signal_connect(sink, "handoff", G_CALLBACK(countFrame), &frames);
+
+    gst_bin_add_many(GST_BIN(pipeline), swapper.bin(), sink, nullptr);
+    GstElement *before = gst_bin_get_by_name(GST_BIN(pipeline), "before");
+    QVERIFY(gst_element_link_many(before, swapper.bin(), sink, nullptr));
+    gst_object_unref(before);
+
+    QVERIFY(gst_element_set_state(pipeline, GST_STATE_PLAYING) != GST_STATE_CHANGE_FAILURE);
+    QTRY_VERIFY(frames.load() > 5);
+
+    // an effect changing the format on the way
+    swapper.setFilters(QStringLiteral("videobalance saturation=0 ! videoconvert ! video/x-raw, format=BGRx"));
+    QTRY_COMPARE(swapper.generation(), 1);
+    int seen = frames.load();
+    QTRY_VERIFY(frames.load() > seen + 5);
+    QVERIFY(contains(swapper.bin(), "videobalance"));
+
+    // quicker than frames come, only the last ones matter
+    swapper.setFilters(QStringLiteral("videoflip method=4"));
+    swapper.setFilters(QStringLiteral("this-element-does-not-exist"));
+    swapper.setFilters(QStringLiteral("videoflip method=1"));
+    QTRY_VERIFY(contains(swapper.bin(), "videoflip") && !contains(swapper.bin(), "videobalance"));
+    seen = frames.load();
+    QTRY_VERIFY(frames.load() > seen + 5);
+
+    GstState state;
+    gst_element_get_state(pipeline, &state, nullptr, GST_CLOCK_TIME_NONE);
+    QCOMPARE(state, GST_STATE_PLAYING);
+
+    GstBus *bus = gst_element_get_bus(pipeline);
+    GstMessage *error = gst_bus_pop_filtered(bus, GST_MESSAGE_ERROR);
+    QVERIFY(!error);
+    gst_object_unref(bus);
+
+    gst_element_set_state(pipeline, GST_STATE_NULL);
+    gst_object_unref(pipeline);
+}
+
+QTEST_GUILESS_MAIN(FilterSwapperTest)
+#include "filterswappertest.moc"
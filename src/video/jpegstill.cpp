@@ -0,0 +1,254 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "jpegstill.h"
+
+#include <QDataStream>
+#include <QDateTime>
+#include <QDebug>
+
+// the tables of JPEG's Annex K.3, as a DHT segment
+static const uchar s_standardHuffmanTables[] = {
+    0xff, 0xc4, 0x01, 0xa2,
+    0x00, 0x00, 0x01, 0x05, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+    0x10, 0x00, 0x02, 0x01, 0x03, 0x03, 0x02, 0x04, 0x03, 0x05, 0x05, 0x04, 0x04, 0x00, 0x00, 0x01, 0x7d,
+    0x01, 0x02, 0x03, 0x00, 0x04, 0x11, 0x05, 0x12, 0x21, 0x31, 0x41, 0x06,
+    0x13, 0x51, 0x61, 0x07, 0x22, 0x71, 0x14, 0x32, 0x81, 0x91, 0xa1, 0x08,
+    0x23, 0x42, 0xb1, 0xc1, 0x15, 0x52, 0xd1, 0xf0, 0x24, 0x33, 0x62, 0x72,
+    0x82, 0x09, 0x0a, 0x16, 0x17, 0x18, 0x19, 0x1a, 0x25, 0x26, 0x27, 0x28,
+    0x29, 0x2a, 0x34, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44, 0x45,
+    0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58, 0x59,
+    0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74, 0x75,
+    0x76, 0x77, 0x78, 0x79, 0x7a, 0x83, 0x84, 0x85, 0x86, 0x87, 0x88, 0x89,
+    0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a, 0xa2, 0xa3,
+    0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4, 0xb5, 0xb6,
+    0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7, 0xc8, 0xc9,
+    0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda, 0xe1, 0xe2,
+    0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf1, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+    0x01, 0x00, 0x03, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x01, 0x00, 0x00, 0x00, 0x00, 0x00,
+    0x00, 0x01, 0x02, 0x03, 0x04, 0x05, 0x06, 0x07, 0x08, 0x09, 0x0a, 0x0b,
+    0x11, 0x00, 0x02, 0x01, 0x02, 0x04, 0x04, 0x03, 0x04, 0x07, 0x05, 0x04, 0x04, 0x00, 0x01, 0x02, 0x77,
+    0x00, 0x01, 0x02, 0x03, 0x11, 0x04, 0x05, 0x21, 0x31, 0x06, 0x12, 0x41,
+    0x51, 0x07, 0x61, 0x71, 0x13, 0x22, 0x32, 0x81, 0x08, 0x14, 0x42, 0x91,
+    0xa1, 0xb1, 0xc1, 0x09, 0x23, 0x33, 0x52, 0xf0, 0x15, 0x62, 0x72, 0xd1,
+    0x0a, 0x16, 0x24, 0x34, 0xe1, 0x25, 0xf1, 0x17, 0x18, 0x19, 0x1a, 0x26,
+    0x27, 0x28, 0x29, 0x2a, 0x35, 0x36, 0x37, 0x38, 0x39, 0x3a, 0x43, 0x44,
+    0x45, 0x46, 0x47, 0x48, 0x49, 0x4a, 0x53, 0x54, 0x55, 0x56, 0x57, 0x58,
+    0x59, 0x5a, 0x63, 0x64, 0x65, 0x66, 0x67, 0x68, 0x69, 0x6a, 0x73, 0x74,
+    0x75, 0x76, 0x77, 0x78, 0x79, 0x7a, 0x82, 0x83, 0x84, 0x85, 0x86, 0x87,
+    0x88, 0x89, 0x8a, 0x92, 0x93, 0x94, 0x95, 0x96, 0x97, 0x98, 0x99, 0x9a,
+    0xa2, 0xa3, 0xa4, 0xa5, 0xa6, 0xa7, 0xa8, 0xa9, 0xaa, 0xb2, 0xb3, 0xb4,
+    0xb5, 0xb6, 0xb7, 0xb8, 0xb9, 0xba, 0xc2, 0xc3, 0xc4, 0xc5, 0xc6, 0xc7,
+    0xc8, 0xc9, 0xca, 0xd2, 0xd3, 0xd4, 0xd5, 0xd6, 0xd7, 0xd8, 0xd9, 0xda,
+    0xe2, 0xe3, 0xe4, 0xe5, 0xe6, 0xe7, 0xe8, 0xe9, 0xea, 0xf2, 0xf3, 0xf4,
+    0xf5, 0xf6, 0xf7, 0xf8, 0xf9, 0xfa,
+};
+
+enum {
+    Marker_SOI = 0xd8,
+    Marker_SOS = 0xda,
+    Marker_DHT = 0xc4,
+    Marker_APP0 = 0xe0,
+    Marker_APP1 = 0xe1
+};
+
+JpegStill::~JpegStill()
+{
+    unwatch();
+}
+
+void JpegStill::watch(GstPad *pad)
+{
+    unwatch();
+
+    m_pad = GST_PAD(gst_object_ref(pad));
+    m_probe = gst_pad_add_probe(m_pad, GST_PAD_PROBE_TYPE_BUFFER, &JpegStill::onBuffer, this, nullptr);
+}
+
+void JpegStill::unwatch()
+{
+    if (m_pad) {
+        gst_pad_remove_probe(m_pad, m_probe);
+        gst_object_unref(m_pad);
+        m_pad = nullptr;
+        m_probe = 0;
+    }
+
+    QMutexLocker l(&m_mutex);
+    if (m_frame) {
+        gst_buffer_unref(m_frame);
+        m_frame = nullptr;
+    }
+}
+
+GstPadProbeReturn JpegStill::onBuffer(GstPad */*pad*/, GstPadProbeInfo *info, gpointer self)
+{
+    JpegStill *still = static_cast<JpegStill*>(self);
+    GstBuffer *frame = gst_buffer_ref(GST_PAD_PROBE_INFO_BUFFER(info));
+
+    QMutexLocker l(&still->m_mutex);
+    if (still->m_frame)
+        gst_buffer_unref(still->m_frame);
+    still->m_frame = frame;
+    return GST_PAD_PROBE_OK;
+}
+
+QByteArray JpegStill::take(bool mirrored, const QDateTime &time)
+{
+    GstBuffer *frame;
+    {
+        QMutexLocker l(&m_mutex);
+        if (!m_frame)
+            return {};
+        frame = gst_buffer_ref(m_frame);
+    }
+
+    QByteArray file;
+    GstMapInfo map;
+    if (gst_buffer_map(frame, &map, GST_MAP_READ)) {
+        file = toFile(QByteArray::fromRawData(reinterpret_cast<const char*>(map.data), map.size), mirrored, time);
+        gst_buffer_unmap(frame, &map);
+    }
+    gst_buffer_unref(frame);
+    return file;
+}
+
+// a little-endian TIFF structure in an APP1 segment, with the few tags
+// that make sense for a webcam picture
+static QByteArray exifSegment(bool mirrored, const QDateTime &time)
+{
+    enum { Type_Ascii = 2, Type_Short = 3, Type_Long = 4 };
+    enum {
+        Tag_Orientation = 0x0112,
+        Tag_Software = 0x0131,
+        Tag_DateTime = 0x0132,
+        Tag_ExifIfd = 0x8769,
+        Tag_DateTimeOriginal = 0x9003
+    };
+
+    const QByteArray software = QByteArrayLiteral("Kamoso") + '\0';
+    const QByteArray date = time.toString(QStringLiteral("yyyy:MM:dd HH:mm:ss")).toLatin1() + '\0';
+
+    // the header, then IFD0 with 4 entries and the Exif IFD with 1, then
+    // the strings that do not fit in an entry
+    const quint32 ifd0 = 8;
+    const quint32 exifIfd = ifd0 + 2 + 4 * 12 + 4;
+    const quint32 softwareOffset = exifIfd + 2 + 1 * 12 + 4;
+    const quint32 dateOffset = softwareOffset + software.size();
+    const quint32 dateOriginalOffset = dateOffset + date.size();
+
+    QByteArray tiff;
+    QDataStream stream(&tiff, QIODevice::WriteOnly);
+    stream.setByteOrder(QDataStream::LittleEndian);
+
+    auto entry = [&stream](quint16 tag, quint16 type, quint32 count, quint32 value) {
+        stream << tag << type << count;
+        // a short is stored in the first half of the value
+        if (type == Type_Short)
+            stream << quint16(value) << quint16(0);
+        else
+            stream << value;
+    };
+
+    stream.writeRawData("II", 2);
+    stream << quint16(42) << ifd0;
+
+    stream << quint16(4);
+    // 2 is the mirror image of 1, the way the camera sees it
+    entry(Tag_Orientation, Type_Short, 1, mirrored ? 2 : 1);
+    entry(Tag_Software, Type_Ascii, software.size(), softwareOffset);
+    entry(Tag_DateTime, Type_Ascii, date.size(), dateOffset);
+    entry(Tag_ExifIfd, Type_Long, 1, exifIfd);
+    stream << quint32(0);
+
+    stream << quint16(1);
+    entry(Tag_DateTimeOriginal, Type_Ascii, date.size(), dateOriginalOffset);
+    stream << quint32(0);
+
+    stream.writeRawData(software.constData(), software.size());
+    stream.writeRawData(date.constData(), date.size());
+    stream.writeRawData(date.constData(), date.size());
+
+    const QByteArray payload = QByteArrayLiteral("Exif") + QByteArray(2, '\0') + tiff;
+    const int length = payload.size() + 2;
+
+    QByteArray segment;
+    segment += char(0xff);
+    segment += char(Marker_APP1);
+    segment += char(length >> 8);
+    segment += char(length & 0xff);
+    return segment + payload;
+}
+
+QByteArray JpegStill::toFile(const QByteArray &frame, bool mirrored, const QDateTime &time)
+{
+    const uchar *data = reinterpret_cast<const uchar*>(frame.constData());
+    const int size = frame.size();
+    if (size < 4 || data[0] != 0xff || data[1] != Marker_SOI)
+        return {};
+
+    // the segments up to the scan; the coded data is copied as it is
+    QByteArray app0, segments;
+    bool hasTables = false;
+    int pos = 2;
+    for (;;) {
+        if (pos + 4 > size || data[pos] != 0xff) {
+            qWarning() << "broken JPEG frame at" << pos << "of" << size;
+            return {};
+        }
+
+        const uchar marker = data[pos + 1];
+        if (marker == 0xff) { // fill byte
+            pos++;
+            continue;
+        }
+        if (marker == Marker_SOS)
+            break;
+
+        const int length = (data[pos + 2] << 8) | data[pos + 3];
+        if (length < 2 || pos + 2 + length > size) {
+            qWarning() << "broken JPEG frame at" << pos << "of" << size;
+            return {};
+        }
+
+        const QByteArray segment = frame.mid(pos, 2 + length);
+        if (marker == Marker_DHT)
+            hasTables = true;
+
+        // JFIF has to stay first, a camera's own EXIF is replaced
+        if (marker == Marker_APP0 && pos == 2)
+            app0 = segment;
+        else if (marker != Marker_APP1)
+            segments += segment;
+        pos += 2 + length;
+    }
+
+    QByteArray file;
+    file.reserve(size + 1024);
+    file += char(0xff);
+    file += char(Marker_SOI);
+    file += app0;
+    file += exifSegment(mirrored, time);
+    file += segments;
+    if (!hasTables)
+        file.append(reinterpret_cast<const char*>(s_standardHuffmanTables), sizeof(s_standardHuffmanTables));
+    file += frame.mid(pos);
+    return file;
+}
@@ -0,0 +1,67 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#ifndef JPEGSTILL_H
+#define JPEGSTILL_H
+
+#include <QByteArray>
+#include <QMutex>
+
+#include <gst/gst.h>
+
+class QDateTime;
+
+/**
+ * Pictures taken straight from an MJPEG camera's frames, without
+ * decoding and encoding them again.
+ *
+ * It holds on to the latest frame that went through a pad, which costs
+ * a reference. Taking a picture writes that frame out, completed into a
+ * file that viewers can read.
+ */
+class JpegStill
+{
+public:
+    JpegStill() = default;
+    ~JpegStill();
+
+    // pad carries image/jpeg; replaces the pad watched before
+    void watch(GstPad *pad);
+    void unwatch();
+
+    // the latest frame as a file, empty if there is none
+    QByteArray take(bool mirrored, const QDateTime &time);
+
+    // what a frame lacks to be a file: the Huffman tables, which MJPEG may
+    // leave out when they are the standard ones, and EXIF. Empty if the
+    // frame is not a JPEG
+    static QByteArray toFile(const QByteArray &frame, bool mirrored, const QDateTime &time);
+
+private:
+    Q_DISABLE_COPY(JpegStill)
+
+    static GstPadProbeReturn onBuffer(GstPad *pad, GstPadProbeInfo *info, gpointer self);
+
+    GstPad *m_pad = nullptr;
+    gulong m_probe = 0;
+
+    QMutex m_mutex;
+    GstBuffer *m_frame = nullptr;
+};
+
+#endif // JPEGSTILL_H
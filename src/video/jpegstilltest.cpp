@@ -0,0 +1,180 @@
+/*************************************************************************************
+ *  Copyright (C) 2026 by Kamoso developers                                          *
+ *                                                                                   *
+ *  This program is free software; you can redistribute it and/or                    *
+ *  modify it under the terms of the GNU General Public License                      *
+ *  as published by the Free Software Foundation; either version 2                   *
+ *  of the License, or (at your option) any later version.                           *
+ *                                                                                   *
+ *  This program is distributed in the hope that it will be useful,                  *
+ *  but WITHOUT ANY WARRANTY; without even the implied warranty of                   *
+ *  MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the                    *
+ *  GNU General Public License for more details.                                     *
+ *                                                                                   *
+ *  You should have received a copy of the GNU General Public License                *
+ *  along with this program; if not, write to the Free Software                      *
+ *  Foundation, Inc., 51 Franklin Street, Fifth Floor, Boston, MA  02110-1301, USA   *
+ *************************************************************************************/
+
+#include "jpegstill.h"
+
+#include <QBuffer>
+#include <QDateTime>
+#include <QImage>
+#include <QImageReader>
+#include <QTest>
+
+class JpegStillTest : public QObject
+{
+    Q_OBJECT
+private Q_SLOTS:
+    void initTestCase();
+    void testToFile_data();
+    void testToFile();
+    void testBroken();
+    void testTake();
+};
+
+static QByteArray jpeg(const QImage &image)
+{
+    QByteArray data;
+    QBuffer buffer(&data);
+    buffer.open(QIODevice::WriteOnly);
+    image.save(&buffer, "JPEG", 90);
+    return data;
+}
+
+// what many UVC cameras send: the tables are left out
+static QByteArray withoutHuffmanTables(const QByteArray &file)
+{
+    QByteArray frame = file.left(2);
+    int pos = 2;
+    while (uchar(file[pos + 1]) != 0xda) {
+        const int length = (uchar(file[pos + 2]) << 8) | uchar(file[pos + 3]);
+        if (uchar(file[pos + 1]) != 0xc4)
+            frame += file.mid(pos, 2 + length);
+        pos += 2 + length;
+    }
+    return frame + file.mid(pos);
+}
+
+static QImage testImage()
+{
+    QImage image(64, 32, QImage::Format_RGB32);
+    image.fill(Qt::blue);
+    for (int y = 0; y < image.height(); y++) {
+        for (int x = 0; x < image.width() / 2; x++)
+            image.setPixel(x, y, qRgb(255, 0, 0));
+    }
+    return image;
+}
+
+static bool similar(QRgb a, QRgb b)
+{
+    return qAbs(qRed(a) - qRed(b)) < 16 && qAbs(qGreen(a) - qGreen(b)) < 16 && qAbs(qBlue(a) - qBlue(b)) < 16;
+}
+
+void JpegStillTest::initTestCase()
+{
+    gst_init(nullptr, nullptr);
+}
+
+void JpegStillTest::testToFile_data()
+{
+    QTest::addColumn<bool>("stripTables");
+    QTest::addColumn<bool>("mirrored");
+
+    QTest::newRow("MJPEG") << true << false;
+    QTest::newRow("MJPEG mirrored") << true << true;
+    QTest::newRow("complete") << false << false;
+}
+
+void JpegStillTest::testToFile()
+{
+    QFETCH(bool, stripTables);
+    QFETCH(bool, mirrored);
+
+    const QByteArray original = jpeg(testImage());
+    const QByteArray frame = stripTables ? withoutHuffmanTables(original) : original;
+    QVERIFY(!frame.contains("\xff\xc4") || !stripTables);
+
+    const QDateTime time(QDate(2026, 3, 14), QTime(15, 9, 26));
+    QByteArray file = JpegStill::toFile(frame, mirrored, time);
+    QVERIFY(!file.isEmpty());
+    QVERIFY(file.contains("Exif"));
+    QVERIFY(file.contains("2026:03:14 15:09:26"));
+    // libjpeg writes a segment per table, the standard ones go in one
+    QCOMPARE(file.count("\xff\xc4"), stripTables ? 1 : original.count("\xff\xc4"));
+
+    // the coded data is the camera's
+    const int scan = frame.indexOf("\xff\xda");
+    QVERIFY(file.endsWith(frame.mid(scan)));
+
+    QBuffer buffer(&file);
+    QImageReader reader(&buffer, "JPEG");
+    QCOMPARE(reader.transformation(), mirrored ? QImageIOHandler::TransformationMirror
+                                               : QImageIOHandler::TransformationNone);
+    reader.setAutoTransform(false);
+    const QImage image = reader.read();
+    QCOMPARE(image.size(), QSize(64, 32));
+    QVERIFY(similar(image.pixel(8, 16), qRgb(255, 0, 0)));
+    QVERIFY(similar(image.pixel(56, 16), qRgb(0, 0, 255)));
+}
+
+void JpegStillTest::testBroken()
+{
+    const QDateTime now = QDateTime::currentDateTime();
+    QVERIFY(JpegStill::toFile(QByteArray(), false, now).isEmpty());
+    QVERIFY(JpegStill::toFile(QByteArrayLiteral("not a JPEG at all"), false, now).isEmpty());
+
+    // cut in the middle of the headers
+    const QByteArray file = jpeg(testImage());
+    QVERIFY(JpegStill::toFile(file.left(40), false, now).isEmpty());
+}
+
+static GstFlowReturn dropBuffer(GstPad *, GstObject *, GstBuffer *buffer)
+{
+    gst_buffer_unref(buffer);
+    return GST_FLOW_OK;
+}
+
+void JpegStillTest::testTake()
+{
+    GstPad *src = gst_pad_new("src", GST_PAD_SRC);
+    GstPad *sink = gst_pad_new("sink", GST_PAD_SINK);
+    gst_pad_set_chain_function(sink, dropBuffer);
+    QCOMPARE(gst_pad_link(src, sink), GST_PAD_LINK_OK);
+    gst_pad_set_active(sink, TRUE);
+    gst_pad_set_active(src, TRUE);
+    gst_pad_push_event(src, gst_event_new_stream_start("jpegstill"));
+    GstSegment segment;
+    gst_segment_init(&segment, GST_FORMAT_TIME);
+    gst_pad_push_event(src, gst_event_new_segment(&segment));
+
+    JpegStill still;
+    still.watch(src);
+    QVERIFY(still.take(false, QDateTime::currentDateTime()).isEmpty());
+
+    // only the latest frame is kept
+    const QByteArray first = withoutHuffmanTables(jpeg(QImage(16, 16, QImage::Format_RGB32)));
+    const QByteArray latest = withoutHuffmanTables(jpeg(testImage()));
+    for (const QByteArray &frame : { first, latest }) {
+        GstBuffer *buffer = gst_buffer_new_allocate(nullptr, frame.size(), nullptr);
+        gst_buffer_fill(buffer, 0, frame.constData(), frame.size());
+        QCOMPARE(gst_pad_push(src, buffer), GST_FLOW_OK);
+    }
+
+    QByteArray file = still.take(false, QDateTime::currentDateTime());
+    QCOMPARE(QImage::fromData(file, "JPEG").size(), QSize(64, 32));
+
+    still.unwatch();
+    QVERIFY(still.take(false, QDateTime::currentDateTime()).isEmpty());
+
+    gst_pad_set_active(src, FALSE);
+    gst_pad_set_active(sink, FALSE);
+    gst_object_unref(src);
+    gst_object_unref(sink);
+}
+
+QTEST_GUILESS_MAIN(JpegStillTest)
+#include "jpegstilltest.moc"
@@ -42,6 +42,7 @@
 #include "QGst/Quick/VideoItem"
 #include <QDir>
 #include <QDebug>
+#include <QSaveFile>
 
 #include <QtQml/QQmlEngine>
 #include <QtQml/QQmlContext>
@@ -96,7 +97,16 @@ public:
         , m_surface(new QGst::Quick::VideoSurface(this))
     {
         g_object_ref(m_surface->videoSink());
-        g_object_set(m_surface->videoSink(), "force-aspect-ratio", true, NULL);
+        // previews are small, there is no point in filtering full frames.
+        // Nothing is waiting on them either, so they can be queued for
+        // a couple of frames to play smoothly.
+        g_object_set(m_surface->videoSink(), "force-aspect-ratio", true, "adaptive-size", true,
+                     "pacing-latency", guint64(50 * GST_MSECOND), NULL);
+
+        // the gallery drawer is closed most of the time
+        connect(m_surface, &QGst::Quick::VideoSurface::visibleChanged, this, [this] {
+            setPlaying(m_playing);
+        });
     }
 
     ~PipelineItem() {
@@ -177,8 +187,11 @@ public:
             Q_EMIT playingChanged(playing);
         }
 
-        if (m_pipeline)
-            gst_element_set_state(GST_ELEMENT(m_pipeline.data()), playing ? GST_STATE_PLAYING : GST_STATE_PAUSED);
+        // a hidden preview keeps its last frame until it is shown again
+        if (m_pipeline) {
+            const bool run = playing && m_surface->isVisible();
+            gst_element_set_state(GST_ELEMENT(m_pipeline.data()), run ? GST_STATE_PLAYING : GST_STATE_PAUSED);
+        }
     }
 
     bool playing() const {
@@ -199,6 +212,24 @@ private:
     QGst::Quick::VideoSurface * const m_surface;
 };
 
+// a camera kept in READY while another one is in use: the device stays
+// open, so taking it back only needs it to go to PLAYING
+struct ParkedCamera
+{
+    ~ParkedCamera() {
+        gst_element_set_state(GST_ELEMENT(pipeline.data()), GST_STATE_NULL);
+    }
+
+    QString udi;
+    GstPointer<GstPipeline> pipeline;
+    GstPointer<GstElement> cameraSource;
+    GstPointer<GstElement> viewfinder;
+    CameraMode mode;
+    QScopedPointer<FilterSwapper> sourceFilter;
+    QScopedPointer<FilterSwapper> imageFilter;
+    QScopedPointer<FilterSwapper> videoFilter;
+};
+
 WebcamControl::WebcamControl()
 {
     gst_init(NULL, NULL);
@@ -222,14 +253,28 @@ WebcamControl::WebcamControl()
     engine->rootContext()->setContextProperty("videoSurface1", m_surface);
     engine->load(QUrl("qrc:/qml/Main.qml"));
 
-    g_object_set(m_surface->videoSink(), "force-aspect-ratio", true, NULL);
+    // one refresh of a 60Hz display: enough to show webcam frames evenly,
+    // little enough not to notice the delay
+    g_object_set(m_surface->videoSink(), "force-aspect-ratio", true,
+                 "pacing-latency", guint64(17 * GST_MSECOND), NULL);
 
+    connect(m_surface, &QGst::Quick::VideoSurface::visibleChanged, this, &WebcamControl::updateViewfinderState);
     connect(DeviceManager::self(), &DeviceManager::playingDeviceChanged, this, &WebcamControl::play);
     connect(DeviceManager::self(), &DeviceManager::noDevices, this, &WebcamControl::stop);
+    connect(DeviceManager::self(), &DeviceManager::rowsAboutToBeRemoved, this, [this](const QModelIndex &, int first, int last) {
+        for (int i = first; i <= last; ++i)
+            dropParkedCamera(DeviceManager::self()->udiAt(i));
+    });
+    // plugged in again, maybe into a port with more bandwidth
+    connect(DeviceManager::self(), &DeviceManager::rowsInserted, this, [this](const QModelIndex &, int first, int last) {
+        for (int i = first; i <= last; ++i)
+            m_failedModes.remove(DeviceManager::self()->udiAt(i));
+    });
 }
 
 WebcamControl::~WebcamControl()
 {
+    qDeleteAll(m_parkedCameras);
     DeviceManager::self()->save();
     Settings::self()->save();
 }
@@ -240,6 +285,7 @@ void WebcamControl::stop()
 
     if(m_pipeline) {
         gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_NULL);
+        detachViewfinder();
         m_pipeline.reset(nullptr);
     }
 }
@@ -250,6 +296,55 @@ bool WebcamControl::play()
     return !dev || playDevice(dev);
 }
 
+// qtjpegdec comes with our video sink and decodes on all cores
+static const char *jpegDecoder()
+{
+    GstElementFactory *factory = gst_element_factory_find("qtjpegdec");
+    if (!factory)
+        return "jpegdec";
+    gst_object_unref(factory);
+    return "qtjpegdec";
+}
+
+// the camera as the viewfinder gets it: in the given mode, decoded if it
+// comes compressed. Without a way to do that, the mode is dropped
+static GstElement *videoSource(Device *device, CameraMode *mode)
+{
+    QByteArray description = "v4l2src name=v4l2src";
+    if (mode->isValid()) {
+        description += " ! capsfilter name=mode";
+        if (mode->isJpeg())
+            description += QByteArray(" ! ") + jpegDecoder();
+    }
+
+    GError *error = nullptr;
+    GstElement *source = gst_parse_bin_from_description(description.constData(), true, &error);
+    if (error) {
+        qWarning() << "cannot read the camera as" << description << error->message;
+        g_error_free(error);
+        if (source)
+            gst_object_unref(source);
+
+        *mode = CameraMode();
+        source = gst_element_factory_make("v4l2src", "v4l2src");
+        g_object_set(source, "device", device->path().toUtf8().constData(), nullptr);
+        return source;
+    }
+
+    GstElement *v4l2src = gst_bin_get_by_name(GST_BIN(source), "v4l2src");
+    g_object_set(v4l2src, "device", device->path().toUtf8().constData(), nullptr);
+    gst_object_unref(v4l2src);
+
+    if (mode->isValid()) {
+        GstElement *filter = gst_bin_get_by_name(GST_BIN(source), "mode");
+        GstCaps *caps = mode->caps();
+        g_object_set(filter, "caps", caps, nullptr);
+        gst_caps_unref(caps);
+        gst_object_unref(filter);
+    }
+    return source;
+}
+
 static gboolean webcamWatch(GstBus     */*bus*/, GstMessage *message, gpointer user_data)
 {
     WebcamControl* wc = static_cast<WebcamControl*>(user_data);
@@ -268,8 +363,13 @@ bool WebcamControl::playDevice(Device *device)
         return true;
     }
 
-    if (m_pipeline)
-        gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_NULL);
+    // the camera source is made for one device and the mode it is read in
+    if (m_currentDevice != device->udi()) {
+        // another camera, or the same one again, gets all its modes back
+        m_failedModes.clear();
+        parkCamera();
+        unparkCamera(device->udi());
+    }
 
     if (!m_cameraSource) {
         m_cameraSource.reset(gst_element_factory_make("wrappercamerabinsrc", "video_balance"));
@@ -280,36 +380,227 @@ bool WebcamControl::playDevice(Device *device)
                        << "please make sure all required gstreamer plugins are installed.";
             return false;
         }
+        gst_object_ref_sink(m_cameraSource.data());
 
-        auto source = gst_element_factory_make("v4l2src", "v4l2src");
-        g_object_set(m_cameraSource.data(), "video-source", source, nullptr);
-    }
+        m_sourceFilter.reset(new FilterSwapper("source-filter"));
+        g_object_set(m_cameraSource.data(), "video-source-filter", m_sourceFilter->bin(), nullptr);
 
-    if (m_currentDevice != device->udi()) {
-        GstElement* source;
-        g_object_get(m_cameraSource.data(), "video-source", &source, nullptr);
-        g_object_set(source, "device", device->path().toUtf8().constData(), nullptr);
+        // probed now that nothing is reading from the camera
+        m_mode = CameraModes::best(CameraModes::forDevice(device), CameraModes::defaultBudget(),
+                                   m_failedModes.value(device->udi()));
+        GstElement *source = videoSource(device, &m_mode);
+        g_object_set(m_cameraSource.data(), "video-source", source, nullptr);
+        watchJpegStill();
     }
 
     if (!m_pipeline) {
         m_pipeline.reset(GST_PIPELINE(gst_element_factory_make("camerabin", "camerabin")));
         gst_bus_add_watch (gst_pipeline_get_bus(m_pipeline.data()), &webcamWatch, this);
         g_object_set(m_pipeline.data(), "camera-source", m_cameraSource.data(), nullptr);
-        g_object_set(m_pipeline.data(), "viewfinder-sink", m_surface->videoSink(), nullptr);
+
+        // the video sink is shared by all cameras, it goes into this bin
+        // while the camera is in use
+        m_viewfinder.reset(gst_bin_new("viewfinder"));
+        gst_object_ref_sink(m_viewfinder.data());
+        gst_element_add_pad(m_viewfinder.data(), gst_ghost_pad_new_no_target("sink", GST_PAD_SINK));
+        g_object_set(m_pipeline.data(), "viewfinder-sink", m_viewfinder.data(), nullptr);
+
+        m_imageFilter.reset(new FilterSwapper("image-filter"));
+        m_videoFilter.reset(new FilterSwapper("video-filter"));
+        g_object_set(m_pipeline.data(),
+                     "image-filter", m_imageFilter->bin(),
+                     "video-filter", m_videoFilter->bin(),
+                     nullptr);
     }
 
+    attachViewfinder();
     setVideoSettings();
 
     gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_READY);
-    auto caps = gst_caps_from_string("video/x-raw, framerate=(fraction){30/1, 15/1}, width=(int)640, height=(int)480, format=(string){YUY2}, pixel-aspect-ratio=(fraction)1/1, interlace-mode=(string)progressive");
+    GstCaps *caps;
+    if (m_mode.isValid()) {
+        qDebug() << "viewfinder mode:" << m_mode.toString();
+        caps = gst_caps_new_simple("video/x-raw",
+                                   "width", G_TYPE_INT, m_mode.size.width(),
+                                   "height", G_TYPE_INT, m_mode.size.height(),
+                                   "framerate", GST_TYPE_FRACTION, m_mode.framerateNumerator, m_mode.framerateDenominator,
+                                   "pixel-aspect-ratio", GST_TYPE_FRACTION, 1, 1,
+                                   nullptr);
+    } else {
+        caps = gst_caps_from_string("video/x-raw, framerate=(fraction){30/1, 15/1}, width=(int)640, height=(int)480, format=(string){YUY2}, pixel-aspect-ratio=(fraction)1/1, interlace-mode=(string)progressive");
+    }
     g_object_set(m_pipeline.data(), "viewfinder-caps", caps, nullptr);
-
-    gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_PLAYING);
+    gst_caps_unref(caps);
 
     m_currentDevice = device->udi();
+    updateViewfinderState();
     return true;
 }
 
+// the camera's own JPEGs make the pictures
+void WebcamControl::watchJpegStill()
+{
+    m_jpegStill.unwatch();
+    if (!m_mode.isJpeg())
+        return;
+
+    GstElement *source = nullptr;
+    g_object_get(m_cameraSource.data(), "video-source", &source, nullptr);
+    GstElement *filter = source && GST_IS_BIN(source) ? gst_bin_get_by_name(GST_BIN(source), "mode") : nullptr;
+    if (filter) {
+        GstPad *pad = gst_element_get_static_pad(filter, "src");
+        m_jpegStill.watch(pad);
+        gst_object_unref(pad);
+        gst_object_unref(filter);
+    }
+    if (source)
+        gst_object_unref(source);
+}
+
+void WebcamControl::attachViewfinder()
+{
+    GstElement *sink = m_surface->videoSink();
+    if (GST_ELEMENT_PARENT(sink) == m_viewfinder.data())
+        return;
+
+    gst_bin_add(GST_BIN(m_viewfinder.data()), sink);
+    GstPad *target = gst_element_get_static_pad(sink, "sink");
+    GstPad *ghost = gst_element_get_static_pad(m_viewfinder.data(), "sink");
+    gst_ghost_pad_set_target(GST_GHOST_PAD(ghost), target);
+    gst_object_unref(ghost);
+    gst_object_unref(target);
+    gst_element_sync_state_with_parent(sink);
+}
+
+// the surface keeps its own reference to the sink
+void WebcamControl::detachViewfinder()
+{
+    GstElement *sink = m_surface->videoSink();
+    if (!m_viewfinder || GST_ELEMENT_PARENT(sink) != m_viewfinder.data())
+        return;
+
+    gst_element_set_state(sink, GST_STATE_NULL);
+    GstPad *ghost = gst_element_get_static_pad(m_viewfinder.data(), "sink");
+    gst_ghost_pad_set_target(GST_GHOST_PAD(ghost), nullptr);
+    gst_object_unref(ghost);
+    gst_bin_remove(GST_BIN(m_viewfinder.data()), sink);
+}
+
+// the camera being left is kept open, if the pool has room for it; the
+// least recently used one is closed otherwise
+void WebcamControl::parkCamera()
+{
+    m_jpegStill.unwatch();
+
+    const int poolSize = Settings::cameraPoolSize();
+    if (!m_pipeline || poolSize <= 0) {
+        if (m_pipeline)
+            gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_NULL);
+        detachViewfinder();
+        m_pipeline.reset(nullptr);
+        m_cameraSource.reset(nullptr);
+        m_viewfinder.reset(nullptr);
+        return;
+    }
+
+    gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_READY);
+    detachViewfinder();
+
+    // nothing it says matters until it is used again
+    GstBus *bus = gst_pipeline_get_bus(m_pipeline.data());
+    gst_bus_remove_watch(bus);
+    gst_object_unref(bus);
+
+    ParkedCamera *parked = new ParkedCamera;
+    parked->udi = m_currentDevice;
+    parked->pipeline.swap(m_pipeline);
+    parked->cameraSource.swap(m_cameraSource);
+    parked->viewfinder.swap(m_viewfinder);
+    parked->sourceFilter.swap(m_sourceFilter);
+    parked->imageFilter.swap(m_imageFilter);
+    parked->videoFilter.swap(m_videoFilter);
+    std::swap(parked->mode, m_mode);
+    m_parkedCameras.prepend(parked);
+
+    while (m_parkedCameras.size() > poolSize)
+        delete m_parkedCameras.takeLast();
+}
+
+bool WebcamControl::unparkCamera(const QString &udi)
+{
+    for (int i = 0; i < m_parkedCameras.size(); ++i) {
+        if (m_parkedCameras.at(i)->udi != udi)
+            continue;
+
+        QScopedPointer<ParkedCamera> parked(m_parkedCameras.takeAt(i));
+        m_pipeline.swap(parked->pipeline);
+        m_cameraSource.swap(parked->cameraSource);
+        m_viewfinder.swap(parked->viewfinder);
+        m_sourceFilter.swap(parked->sourceFilter);
+        m_imageFilter.swap(parked->imageFilter);
+        m_videoFilter.swap(parked->videoFilter);
+        std::swap(m_mode, parked->mode);
+
+        // if the camera went away meanwhile, the error comes again on PLAYING
+        GstBus *bus = gst_pipeline_get_bus(m_pipeline.data());
+        gst_bus_set_flushing(bus, true);
+        gst_bus_set_flushing(bus, false);
+        gst_bus_add_watch(bus, &webcamWatch, this);
+        gst_object_unref(bus);
+
+        watchJpegStill();
+        return true;
+    }
+    return false;
+}
+
+void WebcamControl::dropParkedCamera(const QString &udi)
+{
+    for (int i = 0; i < m_parkedCameras.size(); ++i) {
+        if (m_parkedCameras.at(i)->udi == udi) {
+            delete m_parkedCameras.takeAt(i);
+            return;
+        }
+    }
+}
+
+// nobody sees the viewfinder while the window is minimized, so the camera
+// rests unless a video is being recorded
+void WebcamControl::updateViewfinderState()
+{
+    if (!m_pipeline)
+        return;
+
+    const bool run = m_recording || m_surface->isVisible();
+    gst_element_set_state(GST_ELEMENT(m_pipeline.data()), run ? GST_STATE_PLAYING : GST_STATE_PAUSED);
+}
+
+// whether the camera source failed to deliver frames in the mode asked for,
+// rather than e.g. being busy or gone
+bool WebcamControl::isModeError(GstMessage *message) const
+{
+    if (!m_mode.isValid() || !m_cameraSource
+        || !gst_object_has_as_ancestor(GST_MESSAGE_SRC(message), GST_OBJECT(m_cameraSource.data())))
+        return false;
+
+    GError *e = nullptr;
+    GstStructure *details = nullptr;
+    gst_message_parse_error(message, &e, nullptr);
+    gst_message_parse_error_details(message, const_cast<const GstStructure **>(&details));
+
+    bool modeError = (e->domain == GST_CORE_ERROR && e->code == GST_CORE_ERROR_NEGOTIATION)
+                  || (e->domain == GST_STREAM_ERROR && (e->code == GST_STREAM_ERROR_FORMAT
+                                                        || e->code == GST_STREAM_ERROR_NOT_SUPPORTED));
+
+    // basesrc reports "not-negotiated" as a generic stream error
+    gint flowReturn = GST_FLOW_OK;
+    if (!modeError && details && gst_structure_get_enum(details, "flow-return", GST_TYPE_FLOW_RETURN, &flowReturn))
+        modeError = (flowReturn == GST_FLOW_NOT_NEGOTIATED);
+
+    g_error_free(e);
+    return modeError;
+}
+
 void WebcamControl::onBusMessage(GstMessage* message)
 {
     switch (GST_MESSAGE_TYPE (message)) {
@@ -318,11 +609,25 @@ void WebcamControl::onBusMessage(GstMessage* message)
         break;
     case GST_MESSAGE_ERROR: {//Some error occurred.
         static int error = 0;
+        const bool modeFailed = isModeError(message);
         qCritical() << "error:" << debugMessage(message);
         stop();
-        if (error < 3) {
+
+        // the camera could not deliver the mode picked: the next best is
+        // tried, the old caps once there is none left. The cached modes may
+        // be stale too, they are probed again
+        Device *device = DeviceManager::self()->playingDevice();
+        if (modeFailed && device) {
+            qWarning() << "not using" << m_mode.toString() << "for" << device->description() << "again";
+            m_failedModes[device->udi()] << m_mode;
+            CameraModes::forget(device);
+        }
+        m_jpegStill.unwatch();
+        m_cameraSource.reset(nullptr);
+        if ((modeFailed && device) || error < 3) {
             play();
-            ++error;
+            if (!modeFailed)
+                ++error;
         }
     }   break;
     case GST_MESSAGE_ELEMENT:
@@ -332,6 +637,9 @@ void WebcamControl::onBusMessage(GstMessage* message)
                 const gchar *filename = gst_structure_get_string (structure, "filename");
                 if (m_emitTaken)
                     Q_EMIT photoTaken(QString::fromUtf8(filename));
+
+                // takePhoto() may have woken up a hidden viewfinder
+                updateViewfinderState();
             }
         } else {
             qDebug() << "skipping message..." << GST_MESSAGE_SRC_NAME (message);
@@ -351,9 +659,26 @@ void WebcamControl::takePhoto(const QUrl &url, bool emitTaken)
     }
     m_emitTaken = emitTaken;
 
+    const QString path = url.isLocalFile() ? url.toLocalFile() : QStandardPaths::writableLocation(QStandardPaths::TempLocation)+"/kamoso_photo.jpg";
+    if (takeJpegStill(path)) {
+        if (!url.isLocalFile()) {
+            KIO::copy(QUrl::fromLocalFile(path), url);
+        }
+        if (emitTaken) {
+            Q_EMIT photoTaken(path);
+            KNotification::event(QStringLiteral("photoTaken"), i18n("Photo taken"), i18n("Saved in %1", url.toDisplayString(QUrl::PreferLocalFile)));
+        }
+        return;
+    }
+
+    // e.g. a burst going on while the window is minimized
+    if (pipelineCurrentState(m_pipeline) != GST_STATE_PLAYING) {
+        gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_PLAYING);
+        pipelineCurrentState(m_pipeline);
+    }
+
     g_object_set(m_pipeline.data(), "mode", 1, nullptr);
 
-    const QString path = url.isLocalFile() ? url.toLocalFile() : QStandardPaths::writableLocation(QStandardPaths::TempLocation)+"/kamoso_photo.jpg";
     g_object_set(m_pipeline.data(), "location", path.toUtf8().constData(), nullptr);
 
     g_signal_emit_by_name (m_pipeline.data(), "start-capture", 0);
@@ -367,11 +692,37 @@ void WebcamControl::takePhoto(const QUrl &url, bool emitTaken)
     }
 }
 
+// an MJPEG camera's latest frame is written as it is, as long as there are
+// no effects to apply; mirroring is left to the EXIF orientation
+bool WebcamControl::takeJpegStill(const QString &path)
+{
+    if (!m_mode.isJpeg() || !m_extraFilters.trimmed().isEmpty())
+        return false;
+
+    // a paused viewfinder's frame is too old
+    if (pipelineCurrentState(m_pipeline) != GST_STATE_PLAYING)
+        return false;
+
+    const QByteArray jpeg = m_jpegStill.take(m_mirror, QDateTime::currentDateTime());
+    if (jpeg.isEmpty())
+        return false;
+
+    QSaveFile file(path);
+    if (!file.open(QIODevice::WriteOnly) || file.write(jpeg) != jpeg.size() || !file.commit()) {
+        qWarning() << "could not write" << path << file.errorString();
+        return false;
+    }
+    return true;
+}
+
 void WebcamControl::startRecording()
 {
     QString date = QDateTime::currentDateTime().toString("ddmmyyyy_hhmmss");
     m_tmpVideoPath = QDir::tempPath() + QStringLiteral("/kamoso_%1.mkv").arg(date);
 
+    m_recording = true;
+    updateViewfinderState();
+
     g_object_set(m_pipeline.data(), "mode", 2, nullptr);
     g_object_set(m_pipeline.data(), "location", m_tmpVideoPath.toUtf8().constData(), nullptr);
 
@@ -381,6 +732,10 @@ void WebcamControl::startRecording()
 QString WebcamControl::stopRecording()
 {
     g_signal_emit_by_name (m_pipeline.data(), "stop-capture", 0);
+
+    // the file is still being finished, the camera rests on the next
+    // change of visibility
+    m_recording = false;
     return m_tmpVideoPath;
 }
 
@@ -392,43 +747,86 @@ void WebcamControl::setExtraFilters(const QString& extraFilters)
     }
 }
 
+// the sink draws some effects itself, the GStreamer element is then only
+// needed for the pictures and videos taken
+static bool setSinkEffect(GstElement *sink, const QString &filters)
+{
+    GParamSpec *pspec = g_object_class_find_property(G_OBJECT_GET_CLASS(sink), "effect");
+    if (!pspec || !G_IS_PARAM_SPEC_ENUM(pspec))
+        return false;
+
+    GEnumClass *effects = G_PARAM_SPEC_ENUM(pspec)->enum_class;
+    const GEnumValue *effect = g_enum_get_value_by_nick(effects, filters.trimmed().toUtf8().constData());
+    if (!effect)
+        effect = g_enum_get_value(effects, G_PARAM_SPEC_ENUM(pspec)->default_value);
+
+    g_object_set(sink, "effect", effect->value, nullptr);
+    return effect->value != G_PARAM_SPEC_ENUM(pspec)->default_value;
+}
+
+// chains of these only change the colour of each pixel by itself, the sink
+// can bake them into a lookup table
+static bool isColorFilter(const QString &filters)
+{
+    static const QStringList colorElements = {
+        QStringLiteral("videobalance"), QStringLiteral("coloreffects"), QStringLiteral("gamma")
+    };
+
+    const QStringList elements = filters.split(QLatin1Char('!'));
+    for (const QString &element : elements) {
+        const QString factory = element.trimmed().section(QLatin1Char(' '), 0, 0);
+        if (!colorElements.contains(factory))
+            return false;
+    }
+    return true;
+}
+
+static bool setSinkColorFilter(GstElement *sink, const QString &filters)
+{
+    if (!g_object_class_find_property(G_OBJECT_GET_CLASS(sink), "color-filter"))
+        return false;
+
+    const QByteArray description = isColorFilter(filters) ? filters.trimmed().toUtf8() : QByteArray();
+    g_object_set(sink, "color-filter", description.constData(), nullptr);
+
+    // empty if the elements failed
+    gchar *applied = nullptr;
+    g_object_get(sink, "color-filter", &applied, nullptr);
+    const bool ok = !description.isEmpty() && description == applied;
+    g_free(applied);
+    return ok;
+}
+
 void WebcamControl::updateSourceFilter()
 {
     if (!m_pipeline)
         return;
 
-    const auto prevstate = pipelineCurrentState(m_pipeline);
-    if (prevstate != GST_STATE_NULL)
-        gst_element_set_state(GST_ELEMENT(m_pipeline.data()), GST_STATE_NULL);
+    // the viewfinder is mirrored when drawn, the pictures and videos taken
+    // still need their pixels flipped
+    GstElement *sink = m_surface->videoSink();
+    g_object_set(sink, "mirror", m_mirror, nullptr);
+    const bool sinkEffect = setSinkEffect(sink, m_extraFilters);
+    const bool sinkColorFilter = setSinkColorFilter(sink, m_extraFilters);
 
     //videoflip: use video-direction=horiz, method is deprecated, not changing now because video-direction doesn't seem to be available on gstreamer 1.8 which is still widely used
-    QString filters = m_mirror ? QStringLiteral("videoflip method=4") : QStringLiteral("videoflip method=0");
-    if (!m_extraFilters.isEmpty()) {
-        if (!filters.isEmpty())
-            filters.prepend(QStringLiteral(" ! "));
-        filters.prepend(m_extraFilters);
-    }
-
-    if (!filters.isEmpty()) {
-        GError* error = nullptr;
-        auto elem = gst_parse_bin_from_description(filters.toUtf8().constData(), true, &error);
-        if (error) {
-            qDebug() << "error" << error->message;
-        }
-        Q_ASSERT(!error);
-        g_object_set(m_cameraSource.data(), "video-source-filter", elem, nullptr);
-    } else {
-        g_object_set(m_cameraSource.data(), "video-source-filter", nullptr, nullptr);
-    }
-
-    if (prevstate != GST_STATE_NULL)
-        gst_element_set_state(GST_ELEMENT(m_pipeline.data()), prevstate);
+    QStringList captureFilters;
+    if (sinkEffect || sinkColorFilter)
+        captureFilters << m_extraFilters.trimmed();
+    if (m_mirror)
+        captureFilters << QStringLiteral("videoflip method=4");
+
+    // swapped while the camera keeps running
+    const QString capture = captureFilters.join(QStringLiteral(" ! "));
+    m_imageFilter->setFilters(capture);
+    m_videoFilter->setFilters(capture);
+    m_sourceFilter->setFilters(sinkEffect || sinkColorFilter ? QString() : m_extraFilters.trimmed());
 }
 
 void WebcamControl::setVideoSettings()
 {
     Device *device = DeviceManager::self()->playingDevice();
-    connect(device, &Device::filtersChanged, this, &WebcamControl::setExtraFilters);
+    connect(device, &Device::filtersChanged, this, &WebcamControl::setExtraFilters, Qt::UniqueConnection);
 
     m_extraFilters = device->filters();
     updateSourceFilter();
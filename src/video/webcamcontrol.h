@@ -21,15 +21,21 @@
 #define WEBCAMCONTROL_H
 
 #include <QObject>
+#include <QHash>
+#include <QList>
 #include <QUrl>
 
 #include "gstpointer.h"
+#include "cameramodes.h"
+#include "jpegstill.h"
+#include "filterswapper.h"
 #include <gst/gstpipeline.h>
 #include <gst/gstmessage.h>
 
 namespace QGst { namespace Quick { class VideoSurface; } }
 
 class Device;
+struct ParkedCamera;
 class WebcamControl : public QObject
 {
     Q_OBJECT
@@ -66,15 +72,33 @@ class WebcamControl : public QObject
     private:
         void updateSourceFilter();
         void setVideoSettings();
+        void updateViewfinderState();
+        bool takeJpegStill(const QString &path);
+        bool isModeError(GstMessage *message) const;
+        void watchJpegStill();
+        void attachViewfinder();
+        void detachViewfinder();
+        void parkCamera();
+        bool unparkCamera(const QString &udi);
+        void dropParkedCamera(const QString &udi);
 
         QString m_extraFilters;
         QString m_tmpVideoPath;
         QString m_currentDevice;
         GstPointer<GstPipeline> m_pipeline;
         GstPointer<GstElement> m_cameraSource;
+        CameraMode m_mode;
+        QHash<QString, QVector<CameraMode>> m_failedModes; // per udi, while it stays plugged in
+        JpegStill m_jpegStill;
+        QScopedPointer<FilterSwapper> m_sourceFilter;
+        QScopedPointer<FilterSwapper> m_imageFilter;
+        QScopedPointer<FilterSwapper> m_videoFilter;
+        GstPointer<GstElement> m_viewfinder;
+        QList<ParkedCamera*> m_parkedCameras; // most recently used first
         QGst::Quick::VideoSurface* m_surface = nullptr;
         bool m_emitTaken = true;
         bool m_mirror = true;
+        bool m_recording = false;
 };
 
 #endif // WEBCAMCONTROL_H